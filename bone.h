@@ -1,30 +1,48 @@
 #pragma once
 #include "mgs/model/kmd/kmd.h"
+#include "mgs/model/kmd/kmdskeleton.h"
+#include "mgs/scene/stage/stage.h"
 #include "noesis/plugin/pluginshare.h"
 
+//bones follow the kmd's meshes, one per mesh. noesis wants model space matrices, which the skeleton already has
 inline
-void worldToParent(modelBone_t* bone) {
-    RichMat43 currentMat(bone->mat);
-    RichMat43 parentMat(bone->eData.parent->mat);
-    bone->mat = (currentMat * parentMat).m;
+void fillKMDBones(const KmdSkeleton& skeleton, modelBone_t* noeBones) {
+    for (int i = 0; i < skeleton.numBones(); i++) {
+        RichVec3 bonePosV3 = { skeleton.worldX[i], skeleton.worldY[i], skeleton.worldZ[i] };
+        memcpy_s(&noeBones[i].mat.o, 12, &bonePosV3, 12);
+
+        if (skeleton.parents[i] > -1)
+            noeBones[i].eData.parent = &noeBones[skeleton.parents[i]];
+    }
 }
 
 inline
-modelBone_t* bindKMDBones(KmdMesh* mesh, int numBones, noeRAPI_t* rapi) {
+modelBone_t* bindKMDBones(const KmdSkeleton& skeleton, noeRAPI_t* rapi) {
+    int numBones = skeleton.numBones();
     modelBone_t* noeBones = rapi->Noesis_AllocBones(numBones);
 
-    for (int i = 0; i < numBones; i++) {
-        float x = mesh[i].pos.x;
-        float y = mesh[i].pos.y;
-        float z = mesh[i].pos.z;
+    fillKMDBones(skeleton, noeBones);
 
-        RichVec3 bonePosV3 = { x, y, z };
-        memcpy_s(&noeBones[i].mat.o, 12, &bonePosV3, 12);
+    rapi->rpgSetExData_Bones(noeBones, numBones);
+    return noeBones;
+}
+
+//one skeleton for the whole stage, each model's bones follow on from the previous model's
+inline
+modelBone_t* bindStageBones(const std::vector<StageModel>& models, noeRAPI_t* rapi) {
+    int numBones = 0;
+    for (const StageModel& model : models)
+        numBones += KmdView(model.data.data(), model.data.size()).numMesh();
+
+    modelBone_t* noeBones = rapi->Noesis_AllocBones(numBones);
+    int base = 0;
+
+    KmdSkeleton skeleton;
 
-        if (mesh[i].parent > -1) {
-            noeBones[i].eData.parent = &noeBones[mesh[i].parent];
-            worldToParent(&noeBones[i]);
-        }
+    for (const StageModel& model : models) {
+        buildKmdSkeleton(KmdView(model.data.data(), model.data.size()), skeleton);
+        fillKMDBones(skeleton, &noeBones[base]);
+        base += skeleton.numBones();
     }
 
     rapi->rpgSetExData_Bones(noeBones, numBones);
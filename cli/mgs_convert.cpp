@@ -0,0 +1,586 @@
+#include <map>
+#include <set>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "../mgs/common/util.h"
+#include "../mgs/common/memstats.h"
+#include "../mgs/common/threadpool.h"
+#include "../mgs/archive/dar/darcache.h"
+#include "../mgs/model/kmd/kmdatlas.h"
+#include "../mgs/model/kmd/kmdskeleton.h"
+#include "../mgs/model/kmd/kmdoptimize.h"
+#include "../mgs/model/kmd/kmdsimplify.h"
+#include "../mgs/motion/clip/clip.h"
+#include "../mgs/motion/oar/oarindex.h"
+#include "../mgs/motion/oar/oarmotion.h"
+#include "../mgs/scene/stage/stage.h"
+#include "../mgs/texture/bc/bc.h"
+#include "../mgs/texture/pcx/pcx.h"
+#include "../mgs/export/obj/obj.h"
+#include "../mgs/export/dds/dds.h"
+#include "../mgs/export/gltf/gltf.h"
+
+namespace fs = std::filesystem;
+
+//read by makeTGA
+bool g_mgs1OalphaLoad = false;
+
+struct ConvertJob {
+	fs::path input;
+	fs::path outDir;
+};
+
+struct ConvertResult {
+	bool ok;
+	std::string message;
+};
+
+struct Converter {
+	bool gltf = false;
+	bool atlas = false;
+	bool compress = false;
+	bool stage = false;
+	bool optimize = false;
+	bool quads = false;
+	bool pair = false;
+	bool clips = false;
+	bool compactClips = false;
+	int lodLevels = 0;
+	int atlasPageSize = 1024;
+	GltfOptions gltfOptions;
+	DarCache darCache;
+	OarIndex oarIndex;
+	ThreadPool* pool = NULL;
+	std::mutex claimMutex;
+	std::set<fs::path> claimed;
+
+	std::string textureExt() const {
+		return compress ? ".dds" : ".tga";
+	}
+
+	//textures are shared between models, only the first worker to ask writes one
+	bool claim(const fs::path& output) {
+		std::lock_guard<std::mutex> lock(claimMutex);
+		return claimed.insert(output).second;
+	}
+};
+
+static
+std::vector<uint8_t> readFile(const fs::path& path) {
+	std::vector<uint8_t> data(fs::file_size(path));
+	std::ifstream fs(path, std::ios::binary);
+	fs.read((char*)data.data(), data.size());
+	if (!fs) throw std::runtime_error("read failed");
+	return data;
+}
+
+//welded so triangles can share vertices, then simplified into lods for gltf and reordered for the vertex cache.
+//obj quads need the decode order to find them, so only the vertices are reordered for those
+static
+void optimizeGeometry(const Converter& converter, std::vector<KmdGeometry>& geometry) {
+	bool lods = converter.lodLevels && converter.gltf;
+	if (!converter.optimize && !lods) return;
+
+	converter.pool->parallelFor(geometry.size(), [&](int i) {
+		KmdGeometry& geo = geometry[i];
+		weldKmdGeometry(geo);
+		if (lods) buildKmdLods(geo, converter.lodLevels);
+		if (!converter.optimize) return;
+
+		if (converter.quads && !converter.gltf) {
+			optimizeVertexFetch(geo);
+		} else {
+			optimizeKmdGeometry(geo);
+			for (KmdGeometry& lod : geo.lods) optimizeKmdGeometry(lod);
+		}
+	});
+}
+
+//the oar sharing the model's name, or with --pair the best one beside it whose joints fit numBones,
+//as the plugin picks them. empty if there's none
+static
+fs::path motionPath(Converter& converter, const fs::path& model, int numBones) {
+	if (!converter.pair) {
+		fs::path path = fs::path(model).replace_extension(".oar");
+		return fs::exists(path) ? path : fs::path();
+	}
+
+	std::vector<OarIndexEntry> archives = converter.oarIndex.compatible(model, numBones);
+	return archives.empty() ? fs::path() : archives[0].path;
+}
+
+static
+bool writeFile(const fs::path& path, const uint8_t* data, size_t size) {
+	std::ofstream fs(path, std::ios::binary);
+	fs.write((const char*)data, size);
+	return (bool)fs;
+}
+
+//tga, or dds with bc1/bc3 blocks when compressing
+static
+bool writeTexture(const fs::path& path, const uint8_t* pcx, int size, bool compress) {
+	PcxImage image;
+	if (!decodePcx(pcx, size, image)) return false;
+
+	Arena& scratch = scratchArena();
+	ArenaScope scope(scratch);
+
+	int datasize = image.width * image.height * 4;
+	uint8_t* tga = makeTGA(image.indices.data(), pcxPixels(image, scratch), datasize, image.width, image.height, scratch.allocate<uint8_t>(datasize + 0x12));
+	bool ok;
+
+	if (compress) {
+		const uint8_t* bgra = tga + 0x12;
+		bool alpha = hasAlpha(bgra, (size_t)image.width * image.height);
+		std::vector<uint8_t> blocks = alpha ? encodeBC3(bgra, image.width, image.height) : encodeBC1(bgra, image.width, image.height);
+		std::vector<uint8_t> dds = encodeDds(blocks, image.width, image.height, alpha);
+		ok = writeFile(path, dds.data(), dds.size());
+	} else {
+		ok = writeFile(path, tga, datasize + 0x12);
+	}
+
+	//the tga was counted when made, it goes with the scratch space
+	memRelease(datasize + 0x12);
+	releasePcx(image);
+	return ok;
+}
+
+//textures of one gltf file, asked for once by the atlas and again by every material it left out.
+//images it couldn't place are kept rather than decoded twice, and a missing one is counted once
+struct GltfTextures {
+	Converter& converter;
+	fs::path dir;
+	std::set<uint16_t> missing;
+	std::map<uint16_t, std::shared_ptr<const PcxImage>> unplaced;
+
+	GltfTextures(Converter& converter, const fs::path& dir) : converter(converter), dir(dir) {}
+
+	bool load(uint16_t strcode, PcxImage& image) {
+		auto it = unplaced.find(strcode);
+		if (it != unplaced.end()) {
+			image = *it->second;
+			return true;
+		}
+
+		if (missing.count(strcode)) return false;
+
+		int size;
+		const uint8_t* pcx = converter.darCache.findFile(dir, strcode, 0x70, size);
+		if (pcx && decodePcx(pcx, size, image)) return true;
+
+		missing.insert(strcode);
+		return false;
+	}
+
+	void packAtlas(const std::vector<uint16_t>& strcodes, std::vector<KmdGeometry>& geometry, TextureAtlas& atlas) {
+		AtlasInput images;
+		for (uint16_t strcode : strcodes) {
+			std::shared_ptr<PcxImage> image = std::make_shared<PcxImage>();
+			if (load(strcode, *image)) images.push_back({ strcode, image });
+		}
+
+		buildAtlas(images, converter.atlasPageSize, 2, atlas);
+		for (KmdGeometry& geo : geometry) applyAtlas(atlas, geo);
+
+		//placed images are freed along with images
+		for (auto& image : images) {
+			if (!atlas.rects.count(image.first)) unplaced[image.first] = image.second;
+			else memRelease(pcxBytes(*image.second) - sizeof(PcxImage));
+		}
+	}
+
+	int numMissing() const {
+		return missing.size();
+	}
+};
+
+//motions sharing the model's name are picked up from beside it
+static
+ConvertResult convertKmdGltf(Converter& converter, const ConvertJob& job, const KmdView& kmd, std::vector<KmdGeometry>& geometry) {
+	std::string stem = job.input.stem().u8string();
+	fs::path output = job.outDir / (stem + (converter.gltfOptions.binary ? ".glb" : ".gltf"));
+
+	GltfWriter writer(output.u8string(), converter.gltfOptions);
+	if (!writer.isOpen()) return { false, "can't write gltf" };
+
+	GltfTextures textures(converter, job.input.parent_path());
+	auto loadImage = [&](uint16_t strcode, PcxImage& image) { return textures.load(strcode, image); };
+
+	TextureAtlas atlas;
+	if (converter.atlas) textures.packAtlas(usedStrcodes(geometry), geometry, atlas);
+
+	int model = writer.addModel(stem, kmd, geometry, loadImage, converter.atlas ? &atlas : NULL);
+
+	int numMotion = 0;
+	fs::path oarPath = motionPath(converter, job.input, kmd.numBones());
+
+	if (!oarPath.empty()) {
+		std::vector<uint8_t> oar = readFile(oarPath);
+		numMotion = writer.addMotions(model, oar.data(), oar.size());
+	}
+
+	if (!writer.finish()) return { false, "can't write gltf" };
+
+	std::string message = std::to_string(kmd.numMesh()) + " meshes, " + std::to_string(numMotion) + " motions";
+	if (numMotion && oarPath.stem() != job.input.stem()) message += " from " + oarPath.filename().u8string();
+	if (textures.numMissing()) message += ", " + std::to_string(textures.numMissing()) + " textures missing";
+	return { true, message };
+}
+
+static
+ConvertResult convertKmd(Converter& converter, const ConvertJob& job) {
+	std::vector<uint8_t> data = readFile(job.input);
+	KmdView kmd(data.data(), data.size());
+	if (!kmd.isValid()) return { false, "not a valid kmd" };
+
+	std::vector<KmdGeometry> geometry = decodeKmd(kmd, NULL);
+	optimizeGeometry(converter, geometry);
+	if (converter.gltf) return convertKmdGltf(converter, job, kmd, geometry);
+
+	std::vector<uint16_t> strcodes = usedStrcodes(geometry);
+
+	std::string stem = job.input.stem().u8string();
+	if (!writeObj((job.outDir / (stem + ".obj")).u8string(), stem + ".mtl", kmd, geometry, converter.quads)) return { false, "can't write obj" };
+	if (!writeMtl((job.outDir / (stem + ".mtl")).u8string(), strcodes, converter.textureExt())) return { false, "can't write mtl" };
+
+	int missing = 0;
+	for (uint16_t strcode : strcodes) {
+		fs::path texPath = job.outDir / (intToHexString(strcode) + converter.textureExt());
+		if (!converter.claim(texPath)) continue;
+
+		int size;
+		const uint8_t* pcx = converter.darCache.findFile(job.input.parent_path(), strcode, 0x70, size);
+		if (!pcx || !writeTexture(texPath, pcx, size, converter.compress)) missing++;
+	}
+
+	std::string message = std::to_string(kmd.numMesh()) + " meshes, " + std::to_string(strcodes.size()) + " materials";
+	if (missing) message += ", " + std::to_string(missing) + " textures missing";
+	return { true, message };
+}
+
+//every kmd under the directory goes into one gltf scene with materials shared by strcode.
+//meshes repeated across models are decoded and written once, textures come from the stage's own dars
+static
+ConvertResult convertStage(Converter& converter, const ConvertJob& job) {
+	StageIndex stage = scanStage(job.input);
+	std::vector<StageModel> models = readStageModels(stage);
+	if (models.empty()) return { false, "no valid kmd" };
+
+	StageGeometry geometry = decodeStage(models, converter.pool);
+	optimizeGeometry(converter, geometry.meshes);
+
+	fs::path dir = fs::absolute(job.input).lexically_normal();
+	std::string stem = (dir.has_filename() ? dir : dir.parent_path()).filename().u8string();
+	fs::path output = job.outDir / (stem + (converter.gltfOptions.binary ? ".glb" : ".gltf"));
+
+	GltfWriter writer(output.u8string(), converter.gltfOptions);
+	if (!writer.isOpen()) return { false, "can't write gltf" };
+
+	GltfTextures textures(converter, stage.dir);
+	auto loadImage = [&](uint16_t strcode, PcxImage& image) { return textures.load(strcode, image); };
+
+	std::vector<uint16_t> strcodes = usedStrcodes(geometry.meshes);
+
+	TextureAtlas atlas;
+	if (converter.atlas) textures.packAtlas(strcodes, geometry.meshes, atlas);
+
+	int numMesh = 0;
+	int numMotion = 0;
+
+	for (int i = 0; i < models.size(); i++) {
+		KmdView kmd(models[i].data.data(), models[i].data.size());
+
+		std::vector<const KmdGeometry*> instances;
+		for (int mesh : geometry.instances[i]) instances.push_back(&geometry.meshes[mesh]);
+
+		int model = writer.addModel(stageModelName(stage, models[i]), kmd, instances, loadImage, converter.atlas ? &atlas : NULL);
+		numMesh += kmd.numMesh();
+
+		fs::path oarPath = motionPath(converter, models[i].path, kmd.numBones());
+		if (!oarPath.empty()) {
+			std::vector<uint8_t> oar = readFile(oarPath);
+			numMotion += writer.addMotions(model, oar.data(), oar.size());
+		}
+	}
+
+	if (!writer.finish()) return { false, "can't write gltf" };
+
+	std::string message = std::to_string(models.size()) + " models, " + std::to_string(numMesh) + " meshes (" + std::to_string(geometry.meshes.size()) + " unique), " + std::to_string(strcodes.size()) + " materials, " + std::to_string(numMotion) + " motions";
+	if (textures.numMissing()) message += ", " + std::to_string(textures.numMissing()) + " textures missing";
+	return { true, message };
+}
+
+static
+ConvertResult convertDar(Converter& converter, const ConvertJob& job) {
+	Dar dar(job.input.u8string());
+	int written = 0;
+	int failed = 0;
+
+	for (const DarEntry* entry : dar.entries()) {
+		if (entry->extension != 0x70) continue;
+
+		fs::path texPath = job.outDir / (intToHexString(entry->strcode) + converter.textureExt());
+		if (!converter.claim(texPath)) continue;
+
+		writeTexture(texPath, entry->data, entry->size, converter.compress) ? written++ : failed++;
+	}
+
+	std::string message = std::to_string(written) + " textures";
+	if (failed) message += ", " + std::to_string(failed) + " failed";
+	return { !failed || written, message };
+}
+
+//bytes the motion's keys take once decoded to floats, a frame time and the values for each
+static
+size_t floatKeyBytes(const OarMotion& motion) {
+	size_t bytes = motion.move.size() * sizeof(float) * 4;
+	for (const std::vector<OarRotKey>& rot : motion.rotation) bytes += rot.size() * sizeof(float) * 5;
+	return bytes;
+}
+
+//every motion becomes a gltf or compact clip of its own in a folder named after the archive, decoded and written in parallel.
+//gltf joints take the hierarchy of a kmd sharing the archive's name when it has enough bones, otherwise they sit flat.
+//compact clips are validated and sampled back against the motion, the report gives the largest error
+static
+ConvertResult convertOarClips(Converter& converter, const ConvertJob& job, const std::vector<uint8_t>& data) {
+	std::string stem = job.input.stem().u8string();
+	fs::path clipDir = job.outDir / stem;
+	fs::create_directories(clipDir);
+
+	int numJoints = oarNumJoints(data.data());
+	int numMotion = oarNumMotion(data.data());
+	KmdSkeleton skeleton;
+	bool hasSkeleton = false;
+
+	fs::path kmdPath = fs::path(job.input).replace_extension(".kmd");
+	if (fs::exists(kmdPath)) {
+		std::vector<uint8_t> kmdData = readFile(kmdPath);
+		KmdView kmd(kmdData.data(), kmdData.size());
+
+		if (kmd.isValid()) {
+			buildKmdSkeleton(kmd, skeleton);
+			hasSkeleton = skeleton.numBones() >= numJoints;
+		}
+	}
+
+	std::atomic<int> written(0);
+	std::atomic<size_t> clipBytes(0), floatBytes(0);
+	std::vector<ClipError> errors(numMotion);
+
+	converter.pool->parallelFor(numMotion, [&](int m) {
+		OarMotion motion;
+		if (!decodeOarMotion(data.data(), data.size(), m, motion)) return;
+
+		char name[32];
+		snprintf(name, sizeof(name), "motion_%03d", m);
+
+		bool ok;
+
+		if (converter.compactClips) {
+			std::vector<uint8_t> clip;
+			ok = encodeClip(motion, clip) && validateClip(clip.data(), clip.size());
+			ok = ok && writeFile(clipDir / (name + std::string(".mclip")), clip.data(), clip.size());
+
+			if (ok) {
+				errors[m] = measureClip(clip.data(), motion);
+				clipBytes += clip.size();
+				floatBytes += floatKeyBytes(motion);
+			}
+		} else {
+			fs::path output = clipDir / (name + std::string(converter.gltfOptions.binary ? ".glb" : ".gltf"));
+
+			GltfWriter writer(output.u8string(), converter.gltfOptions);
+			int model = writer.isOpen() ? writer.addSkeleton(stem, hasSkeleton ? &skeleton : NULL, numJoints) : -1;
+			ok = writer.isOpen() && writer.addMotion(model, motion, name) && writer.finish();
+		}
+
+		if (ok) written++;
+		releaseOarMotion(motion);
+	});
+
+	std::string message = std::to_string(written) + " of " + std::to_string(numMotion) + " motions written as clips";
+	if (converter.compactClips) {
+		ClipError maxError;
+		for (const ClipError& error : errors) {
+			maxError.rotation = std::max(maxError.rotation, error.rotation);
+			maxError.translation = std::max(maxError.translation, error.translation);
+		}
+
+		char errorText[64];
+		snprintf(errorText, sizeof(errorText), ", max error %.3f deg, %.4f units", maxError.rotation, maxError.translation);
+		message += ", " + std::to_string(clipBytes / 1024) + " KB (" + std::to_string(floatBytes / 1024) + " KB as float keys)" + errorText;
+	} else if (hasSkeleton) message += ", skeleton from " + kmdPath.filename().u8string();
+	return { written > 0 || !numMotion, message };
+}
+
+//motions only make sense against a model, so archives are checked and reported unless they're written as clips
+static
+ConvertResult convertOar(Converter& converter, const ConvertJob& job) {
+	std::vector<uint8_t> data = readFile(job.input);
+	if (!validateOar(data.data(), data.size())) return { false, "not a valid oar" };
+	if (converter.clips) return convertOarClips(converter, job, data);
+
+	return { true, std::to_string(oarNumMotion(data.data())) + " motions, " + std::to_string(oarNumJoints(data.data())) + " joints" };
+}
+
+static
+ConvertResult convert(Converter& converter, const ConvertJob& job) {
+	std::string ext = job.input.extension().u8string();
+	fs::create_directories(job.outDir);
+
+	if (fs::is_directory(job.input)) return convertStage(converter, job);
+	if (ext == ".kmd") return convertKmd(converter, job);
+	if (ext == ".dar") return convertDar(converter, job);
+	return convertOar(converter, job);
+}
+
+static
+bool isConvertible(const fs::path& path) {
+	std::string ext = path.extension().u8string();
+	return ext == ".kmd" || ext == ".dar" || ext == ".oar";
+}
+
+static
+void collectJobs(const fs::path& input, const fs::path& outDir, bool stage, std::vector<ConvertJob>& jobs) {
+	if (stage && fs::is_directory(input)) {
+		jobs.push_back({ input, outDir });
+		return;
+	}
+
+	if (!fs::is_directory(input)) {
+		if (isConvertible(input)) jobs.push_back({ input, outDir });
+		return;
+	}
+
+	for (const fs::directory_entry& file : fs::recursive_directory_iterator(input)) {
+		if (!file.is_regular_file() || !isConvertible(file.path())) continue;
+
+		fs::path rel = fs::relative(file.path().parent_path(), input);
+		jobs.push_back({ file.path(), outDir / rel });
+	}
+}
+
+static
+void usage() {
+	printf("usage: mgs_convert [-j threads] [-o outdir] [--alpha] [--glb | --gltf] [--quantize] [--atlas] [--optimize] [--quads] [--strips] [--lods n] [--pair] [--clips] [--mclip] [--bc] [--stage] [--mem] <file or directory>...\n");
+	printf("converts .kmd to obj/mtl/tga, extracts .dar textures to tga and checks .oar archives\n");
+	printf("--glb/--gltf write .kmd as gltf instead, with textures and any .oar of the same name\n");
+	printf("--quantize stores gltf vertex data in KHR_mesh_quantization formats\n");
+	printf("--atlas packs each gltf model's textures into shared 1024x1024 pages\n");
+	printf("--optimize welds each mesh and reorders it for the vertex cache\n");
+	printf("--quads keeps the kmd's quads in obj output, --strips writes gltf triangles as strips where they're shorter\n");
+	printf("--lods adds 2 to 4 simplified levels of each mesh to gltf output as MSFT_lod nodes\n");
+	printf("--pair attaches the best .oar beside a gltf model whose joints fit its bones, preferring the one sharing its name\n");
+	printf("--clips writes each motion of an .oar as its own gltf clip, glb unless --gltf is given\n");
+	printf("--mclip writes clips in the compact .mclip format instead, quantized for engines to sample in place\n");
+	printf("--bc writes obj and dar textures as bc1/bc3 dds instead of tga\n");
+	printf("--stage writes each directory as one gltf scene of all its models, glb unless --gltf is given\n");
+	printf("--mem counts allocations by subsystem for each file and reports the process's peak resident memory at the end\n");
+}
+
+int main(int argc, char** argv) {
+	int numThreads = 0;
+	fs::path outDir = "mgs_out";
+	Converter converter;
+	bool memStats = false;
+	std::vector<fs::path> inputs;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			numThreads = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			outDir = fs::u8path(argv[++i]);
+		} else if (!strcmp(argv[i], "--alpha")) {
+			g_mgs1OalphaLoad = true;
+		} else if (!strcmp(argv[i], "--glb") || !strcmp(argv[i], "--gltf")) {
+			converter.gltf = true;
+			converter.gltfOptions.binary = !strcmp(argv[i], "--glb");
+		} else if (!strcmp(argv[i], "--quantize")) {
+			converter.gltfOptions.quantized = true;
+		} else if (!strcmp(argv[i], "--atlas")) {
+			converter.atlas = true;
+		} else if (!strcmp(argv[i], "--optimize")) {
+			converter.optimize = true;
+		} else if (!strcmp(argv[i], "--quads")) {
+			converter.quads = true;
+		} else if (!strcmp(argv[i], "--strips")) {
+			converter.gltfOptions.strips = true;
+		} else if (!strcmp(argv[i], "--lods") && i + 1 < argc) {
+			converter.lodLevels = std::min(std::max(atoi(argv[++i]), 2), 4);
+		} else if (!strcmp(argv[i], "--pair")) {
+			converter.pair = true;
+		} else if (!strcmp(argv[i], "--clips")) {
+			converter.clips = true;
+		} else if (!strcmp(argv[i], "--mclip")) {
+			converter.clips = true;
+			converter.compactClips = true;
+		} else if (!strcmp(argv[i], "--bc")) {
+			converter.compress = true;
+		} else if (!strcmp(argv[i], "--stage")) {
+			converter.stage = true;
+			converter.gltf = true;
+		} else if (!strcmp(argv[i], "--mem")) {
+			memStats = true;
+		} else if (argv[i][0] == '-') {
+			usage();
+			return 1;
+		} else {
+			inputs.push_back(fs::u8path(argv[i]));
+		}
+	}
+
+	if (inputs.empty()) {
+		usage();
+		return 1;
+	}
+
+	std::vector<ConvertJob> jobs;
+	for (const fs::path& input : inputs) {
+		collectJobs(input, outDir, converter.stage, jobs);
+	}
+
+	ThreadPool pool(numThreads);
+	converter.pool = &pool;
+	std::mutex printMutex;
+	int numFailed = 0;
+	MemStats totalStats;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (const ConvertJob& job : jobs) {
+		pool.submit([&, job] {
+			auto jobStart = std::chrono::steady_clock::now();
+			ConvertResult result;
+			MemStats stats;
+
+			try {
+				MemStatsScope memScope(memStats ? &stats : NULL);
+				result = convert(converter, job);
+			} catch (const std::exception& e) {
+				result = { false, e.what() };
+			}
+
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - jobStart).count();
+
+			std::lock_guard<std::mutex> lock(printMutex);
+			if (!result.ok) numFailed++;
+			printf("%-4s %9.2f ms  %s  (%s)\n", result.ok ? "ok" : "FAIL", ms, job.input.u8string().c_str(), result.message.c_str());
+
+			if (memStats) {
+				totalStats.add(stats);
+				printf("     memory: %s, peak %.2f MB live\n", stats.format().c_str(), stats.peakBytes / 1048576.0);
+			}
+		});
+	}
+
+	pool.wait();
+
+	double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%d files, %d failed, %.2f ms on %d threads\n", (int)jobs.size(), numFailed, total, pool.size());
+	if (memStats) printf("memory: %s, process peak resident %.2f MB\n", totalStats.format().c_str(), peakResidentBytes() / 1048576.0);
+
+	return numFailed ? 2 : 0;
+}
\ No newline at end of file
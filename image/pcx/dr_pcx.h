@@ -152,6 +152,7 @@ extern "C" {
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include "../../mgs/common/memstats.h"
 
 #ifndef DR_PCX_NO_STDIO
 #include <stdio.h>
@@ -434,7 +435,6 @@ drpcx_bool32 drpcx__decode_2bit(drpcx* pPCX)
         if (pPCX->header.version == 5) {
             drpcx_uint8 paletteMarker = drpcx__read_byte(pPCX);
             if (paletteMarker == 0x0C) {
-                MessageBoxA(NULL, "Found the image with 2bit palette and at the end", "Blast from the past", 0);
                 // TODO: Implement Me.
             }
         }
@@ -446,7 +446,6 @@ drpcx_bool32 drpcx__decode_2bit(drpcx* pPCX)
     {
         // NOTE: This is completely untested. If anybody knows where I can get a test file please let me know or send it through to me!
         // TODO: Test Me.
-        MessageBoxA(NULL, "2bit + 4planes", "Blast from the past", 0);
 
         for (drpcx_uint32 y = 0; y < pPCX->height; ++y) {
             for (drpcx_uint32 c = 0; c < pPCX->header.bitPlanes; ++c) {
@@ -804,11 +803,12 @@ int drpcx_load(drpcx *pcxResult, drpcx_read_proc onRead, const char* name, void*
     return 1;
 }
 
-uint8_t* makeTGAPalette(uint8_t* paletteIndex, int tgaDataSize, int16_t width, int16_t height) {
+uint8_t* makeTGAPalette(const uint8_t* paletteIndex, int tgaDataSize, int16_t width, int16_t height, uint8_t* out) {
     uint32_t pad = 0;
     uint16_t twenty = 0x2020;
     uint32_t magic = 0x20000;
-    uint8_t* tga = new uint8_t[0x12 + tgaDataSize];
+    uint8_t* tga = out ? out : new uint8_t[0x12 + tgaDataSize];
+    memCount(MEM_TGA, 0x12 + tgaDataSize, out ? 0 : 1);
 
     memcpy(tga + 0x00, &magic, 4);
     memcpy(tga + 0x04, &pad, 4);
@@ -832,11 +832,12 @@ uint8_t* makeTGAPalette(uint8_t* paletteIndex, int tgaDataSize, int16_t width, i
     return tga;
 }
 
-uint8_t* makeTGA(uint8_t *palette, uint8_t* data, int dataSize, int16_t width, int16_t height) {
+uint8_t* makeTGA(const uint8_t *palette, const uint8_t* data, int dataSize, int16_t width, int16_t height, uint8_t* out) {
     uint32_t pad = 0;
     uint16_t twenty = 0x2020;
     uint32_t magic = 0x20000;
-    uint8_t* tga = new uint8_t[0x12 + dataSize];
+    uint8_t* tga = out ? out : new uint8_t[0x12 + dataSize];
+    memCount(MEM_TGA, 0x12 + dataSize, out ? 0 : 1);
 
     memcpy(tga + 0x00, &magic, 4);
     memcpy(tga + 0x04, &pad, 4);
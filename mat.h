@@ -1,7 +1,16 @@
 #pragma once
 #include "mgs/common/util.h"
 #include "mgs/archive/dar/dar.h"
-#include "image/pcx/dr_pcx.h"
+#include "mgs/texture/pcx/pcx.h"
+#include "mgs/texture/atlas/atlas.h"
+#include "mgs/texture/bc/bc.h"
+#include "mgs/texture/cache/imagecache.h"
+#include "mgs/texture/cache/texturecache.h"
+#include "mgs/scene/stage/stage.h"
+
+extern ImageCache* g_mgs1ImageCache;
+extern TextureCache* g_mgs1TexCache;
+extern bool g_mgs1CompressLoad;
 
 inline
 int findMaterialIdx(char* matName, CArrayList<noesisMaterial_t*>& matList) {
@@ -21,66 +30,113 @@ int findTextureIdx(char* texName, CArrayList<noesisTex_t*>& texList) {
     return -1;
 }
 
+//cached images are looked up across every dar before any archive is read, memory first then disk.
+//the dars come from the stage scan made once per load
 inline
-uint8_t* findPcx(noeRAPI_t* rapi, uint16_t& strcode, int& size) {
-    std::filesystem::path p{ rapi->Noesis_GetInputName() };
-    p = p.parent_path();
+std::shared_ptr<const PcxImage> findImage(const StageIndex& stage, uint16_t& strcode) {
+    const std::vector<std::filesystem::path>& darPaths = stage.archives;
+    std::vector<std::string> darKeys;
+    std::vector<uint64_t> darHashes;
+
+    for (const std::filesystem::path& darPath : darPaths) {
+        darKeys.push_back(ImageCache::archiveKey(darPath));
+
+        if (std::shared_ptr<const PcxImage> image = g_mgs1ImageCache->find(darKeys.back(), strcode))
+            return image;
+    }
+
+    if (g_mgs1TexCache) {
+        for (int i = 0; i < darPaths.size(); i++) {
+            darHashes.push_back(g_mgs1TexCache->darHash(darPaths[i]));
+
+            std::shared_ptr<PcxImage> image = std::make_shared<PcxImage>();
+            if (g_mgs1TexCache->find(darHashes.back(), strcode, *image)) {
+                g_mgs1ImageCache->store(darKeys[i], strcode, image);
+                return image;
+            }
+        }
+    }
+
+    for (int i = 0; i < darPaths.size(); i++) {
+        Dar dar = Dar(darPaths[i].u8string());
+
+        if (const DarEntry* entry = dar.findEntry(strcode, 0x70)) {
+            std::shared_ptr<PcxImage> image = std::make_shared<PcxImage>();
+            bool loaded = decodePcx(entry->data, entry->size, *image);
+
+            if (!loaded) return NULL;
 
-    for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(p)) {
-        if (file.path().extension() == ".dar") {
-            Dar dar = Dar(file.path().u8string());
+            if (g_mgs1TexCache && darHashes[i])
+                g_mgs1TexCache->store(darHashes[i], strcode, *image);
 
-            if (uint8_t* pcx = dar.findFile(strcode, 0x70, size))
-                return pcx;
+            g_mgs1ImageCache->store(darKeys[i], strcode, image);
+            return image;
         }
     }
 
     return NULL;
 }
 
+//bc1 when every pixel is opaque, bc3 otherwise. noesis frees the block data with the texture
 inline
-noesisTex_t* loadTexture(noeRAPI_t* rapi, uint16_t& strcode, noesisTex_t **alphaTexture) {
-    int size;
-    uint8_t* texData = findPcx(rapi, strcode, size);
-    if (!texData) return NULL;
-
-    int width;
-    int height;
-    int components;
-
-    drpcx pcxResult{};
-    int loadResult = drpcx_load_memory(&pcxResult, texData, size, false, &width, &height, &components, 4);
-    if (loadResult <= 0 || pcxResult.loaded <= 0) {
-        char s[64];
-        sprintf(s, "Can't load image %04X", strcode);
-        MessageBoxA(NULL, s, "Error", 0);
-        return NULL;
-    }
+noesisTex_t* compressTexture(noeRAPI_t* rapi, const uint8_t* bgra, int width, int height) {
+    bool alpha = hasAlpha(bgra, (size_t)width * height);
+    std::vector<uint8_t> blocks = alpha ? encodeBC3(bgra, width, height) : encodeBC1(bgra, width, height);
+
+    BYTE* data = (BYTE*)rapi->Noesis_UnpooledAlloc(blocks.size());
+    memcpy(data, blocks.data(), blocks.size());
 
-    uint8_t* imageData = pcxResult.pImageData;
-    uint8_t* paletteData = pcxResult.pPaletteIndices;
+    char texName[] = "mgs_bc.dds";
+    noesisTex_t* noeTexture = rapi->Noesis_TextureAllocEx(texName, width, height, data, blocks.size(), alpha ? NOESISTEX_DXT5 : NOESISTEX_DXT1, 0, 0);
+    noeTexture->shouldFreeData = true;
+    return noeTexture;
+}
+
+inline
+noesisTex_t* makeTexture(noeRAPI_t* rapi, const PcxImage& image, noesisTex_t **alphaTexture) {
+    int width = image.width;
+    int height = image.height;
+
+    //expanded pixels and both tgas only live until noesis has its copy
+    Arena& scratch = scratchArena();
+    ArenaScope scope(scratch);
 
     int datasize = width * height * 4;
-    uint8_t* tga = makeTGA(paletteData, imageData, datasize, width, height);
-    uint8_t* alphaTga = makeTGAPalette(paletteData, datasize, width, height);
-    
-    drpcx_free(imageData);
-    drpcx_free(paletteData);
+    uint8_t* tga = makeTGA(image.indices.data(), pcxPixels(image, scratch), datasize, width, height, scratch.allocate<uint8_t>(datasize + 0x12));
+    uint8_t* alphaTga = makeTGAPalette(image.indices.data(), datasize, width, height, scratch.allocate<uint8_t>(datasize + 0x12));
+
+    noesisTex_t* noeTexture;
+    noesisTex_t* noeTextureAlpha;
+
+    if (g_mgs1CompressLoad) {
+        noeTexture = compressTexture(rapi, tga + 0x12, width, height);
+        noeTextureAlpha = compressTexture(rapi, alphaTga + 0x12, width, height);
+    } else {
+        noeTexture = rapi->Noesis_LoadTexByHandler(tga, datasize + 0x12, ".tga");
+        noeTextureAlpha = rapi->Noesis_LoadTexByHandler(alphaTga, datasize + 0x12, ".tga");
+    }
 
-    noesisTex_t* noeTexture = rapi->Noesis_LoadTexByHandler(tga, datasize + 0x12, ".tga");
-    noesisTex_t* noeTextureAlpha = rapi->Noesis_LoadTexByHandler(alphaTga, datasize + 0x12, ".tga");
     if (alphaTexture != nullptr) {
         *alphaTexture = noeTextureAlpha;
     }
 
-    delete[] tga;
-    delete[] alphaTga;
-    delete[] texData;
     return noeTexture;
 }
 
 inline
-void bindMat(uint16_t strcode, BYTE* fileBuffer, noeRAPI_t* rapi, CArrayList<noesisMaterial_t*>& matList, CArrayList<noesisTex_t*>& texList) {
+noesisTex_t* loadTexture(noeRAPI_t* rapi, const StageIndex& stage, uint16_t& strcode, noesisTex_t **alphaTexture) {
+    std::shared_ptr<const PcxImage> image = findImage(stage, strcode);
+
+    if (!image) {
+        rapi->LogOutput("Can't load image %04X\n", strcode);
+        return NULL;
+    }
+
+    return makeTexture(rapi, *image, alphaTexture);
+}
+
+inline
+void bindMat(uint16_t strcode, noeRAPI_t* rapi, const StageIndex& stage, CArrayList<noesisMaterial_t*>& matList, CArrayList<noesisTex_t*>& texList) {
 
     //set mat name
     std::string matStr = intToHexString(strcode);
@@ -123,7 +179,7 @@ void bindMat(uint16_t strcode, BYTE* fileBuffer, noeRAPI_t* rapi, CArrayList<noe
 
     //load texture
     noesisTex_t* alphaMask = nullptr;
-    noesisTex_t* noeTexture = loadTexture(rapi, strcode, &alphaMask);
+    noesisTex_t* noeTexture = loadTexture(rapi, stage, strcode, &alphaMask);
     
     if (!noeTexture || !alphaMask) return;
 
@@ -138,5 +194,40 @@ void bindMat(uint16_t strcode, BYTE* fileBuffer, noeRAPI_t* rapi, CArrayList<noe
     texList.Append(alphaMask);
 
     //set material
+    rapi->rpgSetMaterial(noeMat->name);
+}
+
+inline
+void bindAtlasMat(int page, const TextureAtlas& atlas, noeRAPI_t* rapi, CArrayList<noesisMaterial_t*>& matList, CArrayList<noesisTex_t*>& texList) {
+    char matName[16];
+    snprintf(matName, sizeof(matName), "atlas_%d", page);
+
+    if (findMaterialIdx(matName, matList) > -1) {
+        rapi->rpgSetMaterial(matName);
+        return;
+    }
+
+    char texName[32];
+    char texNameAlpha[32];
+    snprintf(texName, sizeof(texName), "%s.tga", matName);
+    snprintf(texNameAlpha, sizeof(texNameAlpha), "%s_a.tga", matName);
+
+    noesisTex_t* alphaMask = nullptr;
+    noesisTex_t* noeTexture = makeTexture(rapi, atlas.pages[page], &alphaMask);
+
+    if (!noeTexture || !alphaMask) return;
+
+    noeTexture->filename = rapi->Noesis_PooledString(texName);
+    alphaMask->filename = rapi->Noesis_PooledString(texNameAlpha);
+
+    noesisMaterial_t* noeMat = rapi->Noesis_GetMaterialList(1, false);
+    noeMat->name = rapi->Noesis_PooledString(matName);
+    noeMat->noLighting = true;
+    noeMat->texIdx = texList.Num();
+    matList.Append(noeMat);
+
+    texList.Append(noeTexture);
+    texList.Append(alphaMask);
+
     rapi->rpgSetMaterial(noeMat->name);
 }
\ No newline at end of file
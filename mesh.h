@@ -1,94 +1,86 @@
 #pragma once
+#include <set>
 #include "mat.h"
+#include "mgs/model/kmd/kmdcache.h"
+#include "mgs/model/kmd/kmdatlas.h"
+#include "mgs/model/kmd/kmdoptimize.h"
+#include "mgs/model/kmd/kmdsimplify.h"
 
 inline
-void setOrigin(KmdMesh* mesh, modelBone_t* noeBone, noeRAPI_t* rapi) {
+void setOrigin(modelBone_t* noeBone, noeRAPI_t* rapi) {
     modelMatrix_t t = g_identityMatrix;
     g_mfn->Math_VecCopy(noeBone->mat.o, t.o);
     rapi->rpgSetTransform(&t);
 }
 
-
+//positions stay int16, normals are halves and uvs are rescaled from bytes by noesis, atlas uvs stay float
 inline
-void bindVertex(KmdVert* vertices, std::vector<float>& vertexBuffer) {
-    vertexBuffer.push_back(vertices->x);
-    vertexBuffer.push_back(vertices->y);
-    vertexBuffer.push_back(vertices->z);
-}
+void bindQuantized(KmdGeometry& geo, noeRAPI_t* rapi) {
+    float uvScale[3] = { 1 / 256.0f, 1 / 256.0f, 1.0f };
+    float uvBias[3] = { 0.0f, 0.0f, 0.0f };
+
+    if (geo.byteUVs.empty()) {
+        rapi->rpgBindUV1BufferSafe(&geo.uvs[0], RPGEODATA_FLOAT, 8, geo.uvs.size() * 4);
+    } else {
+        rapi->rpgSetUVScaleBias(uvScale, uvBias);
+        rapi->rpgBindUV1BufferSafe(&geo.byteUVs[0], RPGEODATA_UBYTE, 2, geo.byteUVs.size() * 2);
+    }
 
-inline
-void bindNormal(KmdNVert* vertices, std::vector<float>& normalBuffer) {
-    float scale = 1 / 4096.0f;
-    normalBuffer.push_back(vertices->x * scale);
-    normalBuffer.push_back(vertices->y * scale);
-    normalBuffer.push_back(vertices->z * scale);
+    rapi->rpgBindNormalBufferSafe(&geo.halfNormals[0], RPGEODATA_HALFFLOAT, 6, geo.halfNormals.size() * 2);
+    rapi->rpgBindPositionBufferSafe(&geo.shortPositions[0], RPGEODATA_SHORT, 6, geo.shortPositions.size() * 2);
 }
 
+//every texture the model uses goes into as few pages as fit, geometry is remapped onto them
 inline
-void bindUV(KmdUV* uv, std::vector<float>& uvBuffer) {
-    float scale = 256.0f;
-    uvBuffer.push_back(uv->tu / scale);
-    uvBuffer.push_back(uv->tv / scale);
-}
+void buildModelAtlas(noeRAPI_t* rapi, const StageIndex& stage, std::vector<KmdGeometry>& geometry, int pageSize, TextureAtlas& atlas) {
+    std::set<uint16_t> strcodes;
+    for (const KmdGeometry& geo : geometry) {
+        for (const KmdBatch& batch : geo.batches)
+            strcodes.insert(batch.strcode);
+    }
 
-inline
-void bindSkin(int16_t parent, KmdMesh* mesh, int meshNum, std::vector<float>& weightBuffer, std::vector<uint8_t>& boneBuffer) {
-    weightBuffer.push_back(1.0f);
-    int boneIdx = parent == -1 ? meshNum : mesh->parent;
-    boneBuffer.push_back(boneIdx);
+    AtlasInput images;
+    for (uint16_t strcode : strcodes) {
+        if (std::shared_ptr<const PcxImage> image = findImage(stage, strcode))
+            images.push_back({ strcode, image });
+    }
+
+    buildAtlas(images, pageSize, 2, atlas);
+
+    for (KmdGeometry& geo : geometry)
+        applyAtlas(atlas, geo);
 }
 
 inline
-void bindMesh(KmdMesh* mesh, int meshNum, modelBone_t* noeBone, BYTE* fileBuffer, noeRAPI_t* rapi, CArrayList<noesisTex_t*>& texList, CArrayList<noesisMaterial_t*>& matList) {
-    std::vector<float> uvBuffer, normalBuffer, vertexBuffer, weightBuffer;
-    std::vector<uint8_t> boneBuffer, faceBuffer, normalFaceBuffer;
-
-    KmdUV* uvOffset = (KmdUV*)&fileBuffer[mesh->uvOffset];
-    uint8_t* faceOffset = (uint8_t*)&fileBuffer[mesh->faceIndexOffset];
-    KmdVert* vertexOffset = (KmdVert*)&fileBuffer[mesh->vertexIndexOffset];
-    KmdNVert* normalOffset = (KmdNVert*)&fileBuffer[mesh->normalIndexOffset];
-    uint16_t* materialOffset = (uint16_t*)&fileBuffer[mesh->materialOffset];
-    uint8_t* normalFaceOffset = (uint8_t*)&fileBuffer[mesh->normalFaceOffset];
-
-    int x = 0;
-    setOrigin(mesh, noeBone, rapi);
-
-    for (int i = 0; i < mesh->numFace; i++) {
-
-        for (int j = 0; j < 4; j++) {
-            uint8_t fa = faceOffset[x];
-            uint8_t na = normalFaceOffset[x] & 0x7F;
-
-            bindUV(&uvOffset[x++], uvBuffer);
-            bindVertex(&vertexOffset[fa], vertexBuffer);
-            bindNormal(&normalOffset[na], normalBuffer);
-            bindSkin(vertexOffset[fa].w, mesh, meshNum, weightBuffer, boneBuffer);
-        }
+void bindMesh(KmdGeometry& geo, modelBone_t* noeBone, noeRAPI_t* rapi, CArrayList<noesisTex_t*>& texList, CArrayList<noesisMaterial_t*>& matList, const TextureAtlas& atlas, const StageIndex& stage) {
+    if (geo.indices.empty()) return;
+
+    setOrigin(noeBone, rapi);
 
-        faceBuffer.push_back(0);
-        faceBuffer.push_back(2);
-        faceBuffer.push_back(1);
+    rapi->rpgBindBoneIndexBuffer(&geo.bones[0], RPGEODATA_UBYTE, 1, 1);
+    rapi->rpgBindBoneWeightBuffer(&geo.weights[0], RPGEODATA_FLOAT, 4, 1);
 
-        if (faceOffset[x - 2] != faceOffset[x - 1]) {
-            faceBuffer.push_back(0);
-            faceBuffer.push_back(3);
-            faceBuffer.push_back(2);
+    if (geo.quantized) {
+        bindQuantized(geo, rapi);
+    } else {
+        rapi->rpgBindUV1BufferSafe(&geo.uvs[0], RPGEODATA_FLOAT, 8, geo.uvs.size() * 4);
+        rapi->rpgBindNormalBufferSafe(&geo.normals[0], RPGEODATA_FLOAT, 12, geo.normals.size() * 4);
+        rapi->rpgBindPositionBufferSafe(&geo.positions[0], RPGEODATA_FLOAT, 12, geo.positions.size() * 4);
+    }
+
+    for (int i = 0; i < geo.batches.size(); i++) {
+        const KmdBatch& batch = geo.batches[i];
+        int page = geo.batchPages.empty() ? -1 : geo.batchPages[i];
+
+        if (page > -1) {
+            bindAtlasMat(page, atlas, rapi, matList, texList);
+        } else {
+            bindMat(batch.strcode, rapi, stage, matList, texList);
         }
 
-        bindMat(materialOffset[i], fileBuffer, rapi, matList, texList);
-        rapi->rpgBindBoneIndexBuffer(&boneBuffer[0], RPGEODATA_UBYTE, 1, 1);
-        rapi->rpgBindBoneWeightBuffer(&weightBuffer[0], RPGEODATA_FLOAT, 4, 1);
-        rapi->rpgBindUV1BufferSafe(&uvBuffer[0], RPGEODATA_FLOAT, 8, uvBuffer.size() * 4);
-        rapi->rpgBindNormalBufferSafe(&normalBuffer[0], RPGEODATA_FLOAT, 12, normalBuffer.size() * 4);
-        rapi->rpgBindPositionBufferSafe(&vertexBuffer[0], RPGEODATA_FLOAT, 12, vertexBuffer.size() * 4);
-        rapi->rpgCommitTrianglesSafe(&faceBuffer[0], RPGEODATA_UBYTE, faceBuffer.size(), RPGEO_TRIANGLE, 0);
-        rapi->rpgClearBufferBinds();
-
-        uvBuffer.clear();
-        faceBuffer.clear();
-        boneBuffer.clear();
-        normalBuffer.clear();
-        weightBuffer.clear();
-        vertexBuffer.clear();
+        rapi->rpgCommitTrianglesSafe(&geo.indices[batch.firstIndex], RPGEODATA_UINT, batch.numIndices, RPGEO_TRIANGLE, 0);
     }
+
+    rapi->rpgClearBufferBinds();
+    if (geo.quantized && !geo.byteUVs.empty()) rapi->rpgSetUVScaleBias(NULL, NULL);
 }
\ No newline at end of file
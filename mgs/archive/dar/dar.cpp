@@ -1,4 +1,6 @@
 #include "dar.h"
+#include <cstring>
+#include "../../common/memstats.h"
 
 Dar::Dar(std::string filename) {
 	std::ifstream fs;
@@ -6,6 +8,7 @@ Dar::Dar(std::string filename) {
 
 	fs.open(filename, std::ios::binary);
 	uint8_t* p = new uint8_t[dataSize];
+	memCount(MEM_DAR, dataSize);
 	fs.read((char*)p, dataSize);
 	this->darData = p;
 	fs.close();
@@ -13,23 +16,46 @@ Dar::Dar(std::string filename) {
 
 Dar::~Dar() {
 	delete[] darData;
+	memRelease(dataSize);
 }
 
 uint8_t* Dar::findFile(uint16_t id, uint16_t ext, int& size) {
+	const DarEntry* entry = findEntry(id, ext);
+	if (!entry) return NULL;
+
+	size = entry->size;
+	uint8_t* file = new uint8_t[size];
+	memCount(MEM_DAR, size);
+	memcpy(file, entry->data, size);
+	return file;
+}
+
+const DarEntry* Dar::findEntry(uint16_t id, uint16_t ext) const {
 	int ptr = 0;
 
-	while (ptr < dataSize) {
-		DarEntry* entry = (DarEntry*)&darData[ptr];
+	while (ptr + 8 <= dataSize) {
+		const DarEntry* entry = (const DarEntry*)&darData[ptr];
+		if (entry->size > (uint32_t)(dataSize - ptr - 8)) break;
 
-		if (entry->strcode == id && entry->extension == ext) {
-			size = entry->size;
-			uint8_t* file = new uint8_t[size];
-			memcpy(file, &darData[ptr + 8], size);
-			return file;
-		}
+		if (entry->strcode == id && entry->extension == ext) return entry;
 
 		ptr += (entry->size) + 8;
 	}
 
 	return NULL;
+}
+
+std::vector<const DarEntry*> Dar::entries() const {
+	std::vector<const DarEntry*> result;
+	int ptr = 0;
+
+	while (ptr + 8 <= dataSize) {
+		const DarEntry* entry = (const DarEntry*)&darData[ptr];
+		if (entry->size > (uint32_t)(dataSize - ptr - 8)) break;
+
+		result.push_back(entry);
+		ptr += (entry->size) + 8;
+	}
+
+	return result;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include <fstream>
 #include <filesystem>
 
@@ -15,6 +16,9 @@ public:
 	~Dar();
 
 	uint8_t* findFile(uint16_t id, uint16_t ext, int& size);
+	//points into the archive, valid while it lives
+	const DarEntry* findEntry(uint16_t id, uint16_t ext) const;
+	std::vector<const DarEntry*> entries() const;
 private:
 	uint8_t* darData;
 	int dataSize;
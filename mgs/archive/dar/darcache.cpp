@@ -0,0 +1,56 @@
+#include "darcache.h"
+
+std::vector<std::filesystem::path> DarCache::listDir(const std::filesystem::path& dir) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = listings.find(dir);
+		if (it != listings.end()) return it->second;
+	}
+
+	std::vector<std::filesystem::path> files;
+	std::error_code ec;
+
+	for (std::filesystem::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+		if (it->path().extension() == ".dar")
+			files.push_back(it->path());
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	listings.emplace(dir, files);
+	return files;
+}
+
+//read outside the lock, two workers racing on one file both read it and one copy wins
+std::shared_ptr<Dar> DarCache::load(const std::filesystem::path& file) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = dars.find(file);
+		if (it != dars.end()) return it->second;
+	}
+
+	std::shared_ptr<Dar> dar = std::make_shared<Dar>(file.u8string());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return dars.emplace(file, dar).first->second;
+}
+
+std::vector<std::shared_ptr<Dar>> DarCache::archives(const std::filesystem::path& dir) {
+	std::vector<std::shared_ptr<Dar>> result;
+
+	for (const std::filesystem::path& file : listDir(dir)) {
+		result.push_back(load(file));
+	}
+
+	return result;
+}
+
+const uint8_t* DarCache::findFile(const std::filesystem::path& dir, uint16_t id, uint16_t ext, int& size) {
+	for (const std::filesystem::path& file : listDir(dir)) {
+		if (const DarEntry* entry = load(file)->findEntry(id, ext)) {
+			size = entry->size;
+			return entry->data;
+		}
+	}
+
+	return NULL;
+}
\ No newline at end of file
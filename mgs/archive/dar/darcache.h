@@ -0,0 +1,21 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include "dar.h"
+
+//archives shared between workers, each directory is listed and each dar read once
+class DarCache {
+public:
+	std::vector<std::shared_ptr<Dar>> archives(const std::filesystem::path& dir);
+	//points into the cached archive, valid while the cache lives
+	const uint8_t* findFile(const std::filesystem::path& dir, uint16_t id, uint16_t ext, int& size);
+private:
+	std::vector<std::filesystem::path> listDir(const std::filesystem::path& dir);
+	std::shared_ptr<Dar> load(const std::filesystem::path& file);
+
+	std::mutex mutex;
+	std::map<std::filesystem::path, std::vector<std::filesystem::path>> listings;
+	std::map<std::filesystem::path, std::shared_ptr<Dar>> dars;
+};
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "arena.h"
+#include <stdlib.h>
+#include "memstats.h"
+
+Arena::Arena(size_t blockSize) {
+	this->current = 0;
+	this->blockSize = blockSize;
+}
+
+Arena::~Arena() {
+	release();
+}
+
+//blocks past the current one are reused in order, a request too big for the next block gets one of its own
+void* Arena::allocate(size_t size, size_t align) {
+	for (; current < blocks.size(); current++) {
+		Block& block = blocks[current];
+		uintptr_t start = (uintptr_t)block.data;
+		uintptr_t aligned = (start + block.used + align - 1) & ~(uintptr_t)(align - 1);
+
+		if (aligned - start + size <= block.size) {
+			block.used = aligned - start + size;
+			return (void*)aligned;
+		}
+
+		if (current + 1 < blocks.size()) blocks[current + 1].used = 0;
+	}
+
+	size_t newSize = size + align > blockSize ? size + align : blockSize;
+	uint8_t* data = (uint8_t*)malloc(newSize);
+	if (!data) return NULL;
+	memCount(MEM_SCRATCH, newSize);
+
+	blocks.push_back({ data, newSize, 0 });
+	current = blocks.size() - 1;
+	return allocate(size, align);
+}
+
+Arena::Mark Arena::mark() const {
+	if (current == blocks.size()) return { current, 0 };
+	return { current, blocks[current].used };
+}
+
+void Arena::rewind(const Mark& mark) {
+	current = mark.block;
+	if (current < blocks.size()) blocks[current].used = mark.used;
+}
+
+void Arena::release() {
+	memRelease(capacity());
+	for (Block& block : blocks) free(block.data);
+	blocks.clear();
+	current = 0;
+}
+
+size_t Arena::numBlocks() const {
+	return blocks.size();
+}
+
+size_t Arena::capacity() const {
+	size_t total = 0;
+	for (const Block& block : blocks) total += block.size;
+	return total;
+}
+
+Arena& scratchArena() {
+	thread_local Arena arena;
+	return arena;
+}
\ No newline at end of file
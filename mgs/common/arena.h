@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <inttypes.h>
+
+//bump allocator for buffers that only live until the end of one load. memory comes from a few
+//large blocks that are kept when the arena rewinds, so a warm arena makes no system allocations
+class Arena {
+public:
+	struct Mark {
+		size_t block;
+		size_t used;
+	};
+
+	Arena(size_t blockSize = 1 << 20);
+	~Arena();
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* allocate(size_t size, size_t align = 16);
+
+	template <typename T>
+	T* allocate(size_t count) {
+		return (T*)allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+	}
+
+	Mark mark() const;
+	void rewind(const Mark& mark);
+	void release(); //frees every block
+
+	size_t numBlocks() const;
+	size_t capacity() const;
+private:
+	struct Block {
+		uint8_t* data;
+		size_t size;
+		size_t used;
+	};
+
+	std::vector<Block> blocks;
+	size_t current;
+	size_t blockSize;
+};
+
+//lets std containers draw from an arena, nothing is freed until the arena rewinds
+template <typename T>
+struct ArenaAllocator {
+	typedef T value_type;
+
+	Arena* arena;
+
+	ArenaAllocator(Arena& arena) : arena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count) { return arena->allocate<T>(count); }
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+//rewinds the arena to where it was when the scope began
+class ArenaScope {
+public:
+	ArenaScope(Arena& arena) : arena(arena), start(arena.mark()) {}
+	~ArenaScope() { arena.rewind(start); }
+private:
+	Arena& arena;
+	Arena::Mark start;
+};
+
+//one per thread, for scratch inside a single decode call. pool workers keep theirs warm between loads
+Arena& scratchArena();
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+#include <inttypes.h>
+
+//lsb first within each byte, reads past the end return zero bits
+class BitReader {
+public:
+	BitReader(const uint8_t* data, size_t size) : data(data), size(size), bitPos(0) {}
+
+	bool atEnd() const { return bitPos >= size * 8; }
+
+	uint32_t readBits(int numBits) {
+		uint32_t value = 0;
+
+		for (int i = 0; i < numBits; i++, bitPos++) {
+			if (atEnd()) break;
+			value |= ((data[bitPos >> 3] >> (bitPos & 7)) & 1) << i;
+		}
+
+		return value;
+	}
+
+	int32_t readSigned(int numBits) {
+		if (!numBits) return 0;
+		uint32_t value = readBits(numBits);
+		if (value >> (numBits - 1)) value |= ~0u << (numBits - 1);
+		return (int32_t)value;
+	}
+private:
+	const uint8_t* data;
+	size_t size;
+	size_t bitPos;
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "cachedir.h"
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+uint64_t trimCacheDir(const fs::path& dir, const std::string& ext, uint64_t maxBytes, uint64_t targetBytes) {
+	struct Entry {
+		fs::file_time_type time;
+		uint64_t size;
+		fs::path path;
+	};
+
+	std::vector<Entry> entries;
+	std::error_code ec;
+	uint64_t totalBytes = 0;
+
+	for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+		if (it->path().extension() != ext) continue;
+
+		Entry entry = { it->last_write_time(ec), it->file_size(ec), it->path() };
+		totalBytes += entry.size;
+		entries.push_back(entry);
+	}
+
+	if (totalBytes <= maxBytes) return totalBytes;
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+	for (const Entry& entry : entries) {
+		if (totalBytes <= targetBytes) break;
+		if (fs::remove(entry.path, ec)) totalBytes -= entry.size;
+	}
+
+	return totalBytes;
+}
+
+bool writeCacheFile(const fs::path& path, const void* data, size_t size) {
+	fs::path tmpPath = path;
+	tmpPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	{
+		std::ofstream fs(tmpPath, std::ios::binary);
+		fs.write((const char*)data, size);
+		if (!fs) return false;
+	}
+
+	std::error_code ec;
+	fs::rename(tmpPath, path, ec);
+	if (!ec) return true;
+
+	fs::remove(tmpPath, ec);
+	return false;
+}
+
+void touchCacheFile(const fs::path& path) {
+	std::error_code ec;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
\ No newline at end of file
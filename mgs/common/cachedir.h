@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+#include <filesystem>
+
+//removes the oldest files with the given extension once their total passes maxBytes,
+//down to targetBytes. returns the bytes left
+uint64_t trimCacheDir(const std::filesystem::path& dir, const std::string& ext, uint64_t maxBytes, uint64_t targetBytes);
+
+//written under a unique name then renamed, other processes may share the directory
+bool writeCacheFile(const std::filesystem::path& path, const void* data, size_t size);
+
+//refreshes the modification time so trimming drops the least recently used first
+void touchCacheFile(const std::filesystem::path& path);
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "cpu.h"
+#include <inttypes.h>
+
+#ifdef MGS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static
+void cpuid(int leaf, int subleaf, int regs[4]) {
+#ifdef _MSC_VER
+	__cpuidex(regs, leaf, subleaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	regs[0] = a; regs[1] = b; regs[2] = c; regs[3] = d;
+#endif
+}
+
+static
+uint64_t xgetbv0() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static
+CpuFeatures detectFeatures() {
+	int regs[4];
+	cpuid(0, 0, regs);
+	int maxLeaf = regs[0];
+
+	cpuid(1, 0, regs);
+	bool sse2 = regs[3] & (1 << 26);
+	bool osxsave = regs[2] & (1 << 27);
+	bool avx = regs[2] & (1 << 28);
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx && (xgetbv0() & 6) == 6) {
+		cpuid(7, 0, regs);
+		avx2 = regs[1] & (1 << 5);
+	}
+
+	return { sse2, avx2 };
+}
+#else
+static
+CpuFeatures detectFeatures() {
+	return { false, false };
+}
+#endif
+
+const CpuFeatures& cpuFeatures() {
+	static const CpuFeatures features = detectFeatures();
+	return features;
+}
\ No newline at end of file
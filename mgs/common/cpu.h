@@ -0,0 +1,21 @@
+#pragma once
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define MGS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define MGS_TARGET_SSE2
+#define MGS_TARGET_AVX2
+#else
+#define MGS_TARGET_SSE2 __attribute__((target("sse2")))
+#define MGS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//checked once with cpuid, avx2 also needs the os to save ymm state
+struct CpuFeatures {
+	bool sse2;
+	bool avx2;
+};
+
+const CpuFeatures& cpuFeatures();
\ No newline at end of file
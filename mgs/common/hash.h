@@ -0,0 +1,16 @@
+#pragma once
+#include <stddef.h>
+#include <inttypes.h>
+
+//fnv-1a, 64 bit
+inline
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull) {
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "memstats.h"
+#include <stdio.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static thread_local MemStats* activeStats = NULL;
+
+static const char* categoryNames[MEM_NUM_CATEGORIES] = { "dar", "pcx", "tga", "geometry", "motion", "scratch" };
+
+void MemStats::add(const MemStats& other) {
+	for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		allocs[i] += other.allocs[i];
+		bytes[i] += other.bytes[i];
+	}
+
+	peakBytes = std::max(peakBytes, liveBytes + other.peakBytes);
+	liveBytes += other.liveBytes;
+}
+
+void MemStats::addConcurrent(const MemStats& other) {
+	for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		allocs[i] += other.allocs[i];
+		bytes[i] += other.bytes[i];
+	}
+
+	peakBytes += other.peakBytes;
+	liveBytes += other.liveBytes;
+}
+
+//categories nothing was counted in are left out
+std::string MemStats::format() const {
+	std::string out;
+
+	for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		if (!allocs[i] && !bytes[i]) continue;
+
+		char entry[64];
+		snprintf(entry, sizeof(entry), "%s%s %llu/%.2f MB", out.empty() ? "" : ", ", categoryNames[i], (unsigned long long)allocs[i], bytes[i] / 1048576.0);
+		out += entry;
+	}
+
+	return out.empty() ? "none" : out;
+}
+
+void memCount(MemCategory category, size_t bytes, int allocs) {
+	if (!activeStats) return;
+
+	activeStats->allocs[category] += allocs;
+	activeStats->bytes[category] += bytes;
+	activeStats->liveBytes += bytes;
+	activeStats->peakBytes = std::max(activeStats->peakBytes, activeStats->liveBytes);
+}
+
+void memRelease(size_t bytes) {
+	if (!activeStats) return;
+	activeStats->liveBytes -= bytes;
+}
+
+MemStats* installedMemStats() {
+	return activeStats;
+}
+
+MemStatsScope::MemStatsScope(MemStats* stats) {
+	previous = activeStats;
+	activeStats = stats;
+}
+
+MemStatsScope::~MemStatsScope() {
+	activeStats = previous;
+}
+
+uint64_t peakResidentBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage)) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <stddef.h>
+#include <inttypes.h>
+
+enum MemCategory {
+	MEM_DAR,      //archive reads and file copies
+	MEM_PCX,      //decoder buffers and decoded images
+	MEM_TGA,      //tga wrappers handed to noesis or written out
+	MEM_GEOMETRY, //decoded mesh streams
+	MEM_MOTION,   //decoded motions and keyframe arrays
+	MEM_SCRATCH,  //arena blocks
+	MEM_NUM_CATEGORIES
+};
+
+//allocations and bytes by subsystem, counted where each subsystem creates its buffers. buffers dropped
+//before the work ends are released again, so liveBytes follows what is held and peakBytes its high water mark
+struct MemStats {
+	uint64_t allocs[MEM_NUM_CATEGORIES] = {};
+	uint64_t bytes[MEM_NUM_CATEGORIES] = {};
+	int64_t liveBytes = 0;
+	int64_t peakBytes = 0;
+
+	//other's work came after this one's, its peak sits on top of what is live here
+	void add(const MemStats& other);
+	//other's work ran alongside this one's, so both peaks may have been held at once
+	void addConcurrent(const MemStats& other);
+	std::string format() const;
+};
+
+//counts into the stats installed on the calling thread, nothing when none are
+void memCount(MemCategory category, size_t bytes, int allocs = 1);
+//takes bytes counted earlier on this thread off the live total
+void memRelease(size_t bytes);
+//the stats installed on the calling thread, or NULL
+MemStats* installedMemStats();
+
+//opts the calling thread in for its lifetime, restoring whatever was installed before. NULL stops counting
+class MemStatsScope {
+public:
+	MemStatsScope(MemStats* stats);
+	~MemStatsScope();
+private:
+	MemStats* previous;
+};
+
+//high water mark of the whole process, from the os
+uint64_t peakResidentBytes();
\ No newline at end of file
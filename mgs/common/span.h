@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+
+template <typename T>
+struct Span {
+	T* ptr = nullptr;
+	size_t count = 0;
+
+	T* data() const { return ptr; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	T* begin() const { return ptr; }
+	T* end() const { return ptr + count; }
+
+	T& operator[](size_t i) const { return ptr[i]; }
+};
\ No newline at end of file
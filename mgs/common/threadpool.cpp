@@ -0,0 +1,129 @@
+#include "threadpool.h"
+#include <atomic>
+#include <memory>
+#include "memstats.h"
+
+ThreadPool::ThreadPool(int numThreads) {
+	this->pending = 0;
+	this->stopping = false;
+
+	if (numThreads <= 0) numThreads = std::thread::hardware_concurrency();
+	if (numThreads <= 0) numThreads = 1;
+
+	for (int i = 0; i < numThreads; i++) {
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	taskReady.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+int ThreadPool::size() const {
+	return workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+		pending++;
+	}
+
+	taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	taskDone.wait(lock, [this] { return pending == 0; });
+}
+
+void ThreadPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (tasks.empty()) return;
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending--;
+		}
+
+		taskDone.notify_all();
+	}
+}
+
+struct ParallelForState {
+	std::atomic<int> next{ 0 };
+	int count;
+	int done;
+	bool counting;      //the caller has memory stats installed
+	MemStats loopStats; //every thread's, added to under the mutex
+	std::mutex mutex;
+	std::condition_variable finished;
+};
+
+static
+void runParallelFor(ParallelForState* state, const std::function<void(int)>& task) {
+	int i;
+	int ran = 0;
+	MemStats stats;
+
+	{
+		MemStatsScope memScope(state->counting ? &stats : NULL);
+
+		while ((i = state->next++) < state->count) {
+			task(i);
+			ran++;
+		}
+	}
+
+	if (!ran) return;
+
+	std::lock_guard<std::mutex> lock(state->mutex);
+	if (state->counting) state->loopStats.addConcurrent(stats);
+	state->done += ran;
+	if (state->done == state->count) state->finished.notify_all();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+	if (count <= 0) return;
+
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+	state->count = count;
+	state->done = 0;
+	MemStats* stats = installedMemStats();
+	state->counting = stats != NULL;
+
+	//helpers that start after the work is gone only touch the shared state
+	int helpers = count - 1 < size() ? count - 1 : size();
+	for (int i = 0; i < helpers; i++) {
+		submit([state, &task] { runParallelFor(state.get(), task); });
+	}
+
+	runParallelFor(state.get(), task);
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&] { return state->done == state->count; });
+
+	//threads running at once may each have been at their peak together
+	if (stats) stats->add(state->loopStats);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool {
+public:
+	ThreadPool(int numThreads = 0);
+	~ThreadPool();
+
+	int size() const;
+	void submit(std::function<void()> task);
+	void wait();
+
+	//calling thread takes part, so it is safe to call from inside a pool task.
+	//what the task counts on any thread goes to the caller's memory stats
+	void parallelFor(int count, const std::function<void(int)>& task);
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskReady;
+	std::condition_variable taskDone;
+	int pending;
+	bool stopping;
+};
\ No newline at end of file
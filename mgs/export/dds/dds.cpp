@@ -0,0 +1,44 @@
+#include "dds.h"
+#include <string.h>
+
+struct DdsPixelFormat {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t masks[4];
+};
+
+struct DdsHeader {
+	uint32_t magic;
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DdsPixelFormat format;
+	uint32_t caps[4];
+	uint32_t reserved2;
+};
+
+std::vector<uint8_t> encodeDds(const std::vector<uint8_t>& blocks, int width, int height, bool bc3) {
+	DdsHeader header = {};
+	header.magic = 0x20534444; //DDS
+	header.size = 124;
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000; //caps, height, width, pixelformat, linearsize
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = blocks.size();
+	header.format.size = 32;
+	header.format.flags = 0x4; //fourcc
+	header.format.fourCC = bc3 ? 0x35545844 : 0x31545844; //DXT5, DXT1
+	header.caps[0] = 0x1000; //texture
+
+	std::vector<uint8_t> dds(sizeof(header) + blocks.size());
+	memcpy(&dds[0], &header, sizeof(header));
+	if (!blocks.empty()) memcpy(&dds[sizeof(header)], blocks.data(), blocks.size());
+	return dds;
+}
\ No newline at end of file
@@ -0,0 +1,6 @@
+#pragma once
+#include <vector>
+#include <inttypes.h>
+
+//single mip dds around bc1 (DXT1) or bc3 (DXT5) blocks
+std::vector<uint8_t> encodeDds(const std::vector<uint8_t>& blocks, int width, int height, bool bc3);
\ No newline at end of file
@@ -0,0 +1,656 @@
+#include "gltf.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include "../png/png.h"
+#include "../../model/kmd/kmdskeleton.h"
+#include "../../model/kmd/kmdtopology.h"
+#include "../../common/util.h"
+
+#define GLTF_BYTE           5120
+#define GLTF_UNSIGNED_BYTE  5121
+#define GLTF_SHORT          5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT   5125
+#define GLTF_FLOAT          5126
+
+#define GLTF_ARRAY_BUFFER         34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+
+#define GLTF_TRIANGLE_STRIP 5
+
+static
+std::string num(double v) {
+	char s[32];
+	snprintf(s, sizeof(s), "%.9g", v);
+	return s;
+}
+
+static
+std::string str(const std::string& v) {
+	std::string out = "\"";
+
+	for (char c : v) {
+		if (c == '"' || c == '\\') out += '\\';
+		out += c;
+	}
+
+	return out + "\"";
+}
+
+static
+std::string intList(const std::vector<int>& values) {
+	std::string out = "[";
+
+	for (int i = 0; i < values.size(); i++) {
+		if (i) out += ",";
+		out += std::to_string(values[i]);
+	}
+
+	return out + "]";
+}
+
+static
+std::string floatList(const float* values, int count) {
+	std::string out = "[";
+
+	for (int i = 0; i < count; i++) {
+		if (i) out += ",";
+		out += num(values[i]);
+	}
+
+	return out + "]";
+}
+
+int JsonArray::add(const std::string& item) {
+	if (count) body += ",";
+	body += item;
+	return count++;
+}
+
+GltfWriter::GltfWriter(const std::string& path, const GltfOptions& options) {
+	this->path = path;
+	this->options = options;
+	this->binPath = options.binary ? path + ".tmp" : std::filesystem::u8path(path).replace_extension(".bin").u8string();
+	this->bin = fopen(binPath.c_str(), "wb");
+	this->binSize = 0;
+	this->usesQuantization = false;
+	this->usesLod = false;
+}
+
+GltfWriter::~GltfWriter() {
+	if (bin) {
+		fclose(bin);
+		remove(binPath.c_str());
+	}
+}
+
+bool GltfWriter::isOpen() const {
+	return bin != NULL;
+}
+
+//bufferViews start 4 byte aligned, which covers every component type used here
+int GltfWriter::addBufferView(const void* data, size_t size, int stride, int target) {
+	static const uint8_t pad[4] = {};
+	size_t padding = (4 - binSize % 4) % 4;
+	fwrite(pad, 1, padding, bin);
+	binSize += padding;
+
+	std::string view = "{\"buffer\":0,\"byteOffset\":" + std::to_string(binSize) + ",\"byteLength\":" + std::to_string(size);
+	if (stride) view += ",\"byteStride\":" + std::to_string(stride);
+	if (target) view += ",\"target\":" + std::to_string(target);
+	view += "}";
+
+	fwrite(data, 1, size, bin);
+	binSize += size;
+	return bufferViews.add(view);
+}
+
+int GltfWriter::addAccessor(int bufferView, size_t byteOffset, int componentType, bool normalized, size_t count, const char* type, const float* min, const float* max) {
+	std::string accessor = "{\"bufferView\":" + std::to_string(bufferView);
+	if (byteOffset) accessor += ",\"byteOffset\":" + std::to_string(byteOffset);
+	accessor += ",\"componentType\":" + std::to_string(componentType);
+	if (normalized) accessor += ",\"normalized\":true";
+	accessor += ",\"count\":" + std::to_string(count) + ",\"type\":" + str(type);
+
+	int numComponents = !strcmp(type, "SCALAR") ? 1 : type[3] - '0';
+	if (min) accessor += ",\"min\":" + floatList(min, numComponents);
+	if (max) accessor += ",\"max\":" + floatList(max, numComponents);
+
+	return accessors.add(accessor + "}");
+}
+
+//bgra to rgba
+static
+std::vector<uint8_t> swizzle(const std::vector<uint8_t>& bgra) {
+	std::vector<uint8_t> rgba(bgra.size());
+
+	for (size_t i = 0; i < rgba.size(); i += 4) {
+		rgba[i + 0] = bgra[i + 2];
+		rgba[i + 1] = bgra[i + 1];
+		rgba[i + 2] = bgra[i + 0];
+		rgba[i + 3] = bgra[i + 3];
+	}
+
+	return rgba;
+}
+
+//paletted pages stay indexed, a quarter of the size of the expanded png
+int GltfWriter::addImage(const PcxImage& image) {
+	std::vector<uint8_t> png;
+
+	if (isIndexed(image)) {
+		png = encodePngIndexed(image.indices.data(), swizzle(image.palette).data(), image.width, image.height);
+	} else {
+		png = encodePng(swizzle(image.pixels).data(), image.width, image.height);
+	}
+
+	int view = addBufferView(png.data(), png.size(), 0, 0);
+	return images.add("{\"bufferView\":" + std::to_string(view) + ",\"mimeType\":\"image/png\"}");
+}
+
+int GltfWriter::addMaterial(const std::string& name, const PcxImage* image) {
+	std::string pbr = "\"metallicFactor\":0,\"roughnessFactor\":1";
+
+	if (image) {
+		int texture = textures.add("{\"source\":" + std::to_string(addImage(*image)) + "}");
+		pbr += ",\"baseColorTexture\":{\"index\":" + std::to_string(texture) + "}";
+	}
+
+	return materials.add("{\"name\":" + str(name) + ",\"pbrMetallicRoughness\":{" + pbr + "},\"extensions\":{\"KHR_materials_unlit\":{}}}");
+}
+
+//one material per strcode, shared by every model added to this file
+int GltfWriter::addMaterial(uint16_t strcode, const GltfImageLoader& loadImage) {
+	auto it = materialIdx.find(strcode);
+	if (it != materialIdx.end()) return it->second;
+
+	PcxImage image;
+	bool loaded = loadImage && loadImage(strcode, image);
+
+	int idx = addMaterial(intToHexString(strcode), loaded ? &image : NULL);
+	materialIdx[strcode] = idx;
+	releasePcx(image);
+	return idx;
+}
+
+static
+bool fitsShort(const std::vector<float>& positions, const float* offset) {
+	for (size_t i = 0; i < positions.size(); i++) {
+		float v = positions[i] + offset[i % 3];
+		if (v < -32768.0f || v > 32767.0f) return false;
+	}
+
+	return true;
+}
+
+void GltfWriter::addAttributes(const KmdGeometry& geo, const float* offset, bool skinned, std::string& attributes) {
+	size_t numVertex = geo.weights.size();
+
+	float min[3] = { INFINITY, INFINITY, INFINITY };
+	float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (size_t i = 0; i < numVertex * 3; i++) {
+		float v = geo.positions[i] + offset[i % 3];
+		if (v < min[i % 3]) min[i % 3] = v;
+		if (v > max[i % 3]) max[i % 3] = v;
+	}
+
+	int position, normal, uv;
+
+	//short vec3 attributes are padded to 8 bytes, as strides must be 4 aligned
+	if (options.quantized && fitsShort(geo.positions, offset)) {
+		std::vector<int16_t> data(numVertex * 4);
+		for (size_t i = 0; i < numVertex; i++) {
+			for (int c = 0; c < 3; c++) data[i * 4 + c] = (int16_t)(geo.positions[i * 3 + c] + offset[c]);
+		}
+		position = addAccessor(addBufferView(data.data(), data.size() * 2, 8, GLTF_ARRAY_BUFFER), 0, GLTF_SHORT, false, numVertex, "VEC3", min, max);
+	} else {
+		std::vector<float> data(numVertex * 3);
+		for (size_t i = 0; i < numVertex * 3; i++) data[i] = geo.positions[i] + offset[i % 3];
+		position = addAccessor(addBufferView(data.data(), data.size() * 4, 0, GLTF_ARRAY_BUFFER), 0, GLTF_FLOAT, false, numVertex, "VEC3", min, max);
+	}
+
+	//kmd normals are close to but not exactly unit length
+	std::vector<float> normals(numVertex * 3);
+	for (size_t i = 0; i < numVertex; i++) {
+		const float* n = &geo.normals[i * 3];
+		float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		float scale = len > 0.0f ? 1.0f / len : 0.0f;
+		for (int c = 0; c < 3; c++) normals[i * 3 + c] = n[c] * scale;
+		if (len == 0.0f) normals[i * 3 + 1] = 1.0f;
+	}
+
+	if (options.quantized) {
+		std::vector<int16_t> data(numVertex * 4);
+		for (size_t i = 0; i < numVertex; i++) {
+			for (int c = 0; c < 3; c++) data[i * 4 + c] = (int16_t)lrintf(normals[i * 3 + c] * 32767.0f);
+		}
+		normal = addAccessor(addBufferView(data.data(), data.size() * 2, 8, GLTF_ARRAY_BUFFER), 0, GLTF_SHORT, true, numVertex, "VEC3");
+
+		//normalized ushort covers both kmd byte uvs and atlas pages at the same 4 bytes as padded bytes
+		std::vector<uint16_t> uvs(numVertex * 2);
+		for (size_t i = 0; i < numVertex * 2; i++) {
+			uvs[i] = (uint16_t)lrintf(std::min(std::max(geo.uvs[i], 0.0f), 1.0f) * 65535.0f);
+		}
+		uv = addAccessor(addBufferView(uvs.data(), uvs.size() * 2, 0, GLTF_ARRAY_BUFFER), 0, GLTF_UNSIGNED_SHORT, true, numVertex, "VEC2");
+		usesQuantization = true;
+	} else {
+		normal = addAccessor(addBufferView(normals.data(), normals.size() * 4, 0, GLTF_ARRAY_BUFFER), 0, GLTF_FLOAT, false, numVertex, "VEC3");
+		uv = addAccessor(addBufferView(geo.uvs.data(), geo.uvs.size() * 4, 0, GLTF_ARRAY_BUFFER), 0, GLTF_FLOAT, false, numVertex, "VEC2");
+	}
+
+	attributes = "\"POSITION\":" + std::to_string(position) + ",\"NORMAL\":" + std::to_string(normal) + ",\"TEXCOORD_0\":" + std::to_string(uv);
+	if (!skinned) return;
+
+	//every vertex is rigidly bound to a single bone
+	std::vector<uint8_t> joints(numVertex * 4);
+	std::vector<uint8_t> weights(numVertex * 4);
+	for (size_t i = 0; i < numVertex; i++) {
+		joints[i * 4] = geo.bones[i];
+		weights[i * 4] = 0xFF;
+	}
+
+	int joint = addAccessor(addBufferView(joints.data(), joints.size(), 0, GLTF_ARRAY_BUFFER), 0, GLTF_UNSIGNED_BYTE, false, numVertex, "VEC4");
+	int weight = addAccessor(addBufferView(weights.data(), weights.size(), 0, GLTF_ARRAY_BUFFER), 0, GLTF_UNSIGNED_BYTE, true, numVertex, "VEC4");
+	attributes += ",\"JOINTS_0\":" + std::to_string(joint) + ",\"WEIGHTS_0\":" + std::to_string(weight);
+}
+
+//geometry already written with the same offset and skinning is reused as an instance
+int GltfWriter::addMesh(const std::string& name, const KmdGeometry& geo, const float* offset, bool skinned, const GltfImageLoader& loadImage, const TextureAtlas* atlas) {
+	if (geo.indices.empty() || geo.quantized) return -1;
+
+	auto instance = std::make_tuple(&geo, skinned, offset[0], offset[1], offset[2]);
+	auto it = meshInstances.find(instance);
+	if (it != meshInstances.end()) return it->second;
+
+	std::string attributes;
+	addAttributes(geo, offset, skinned, attributes);
+
+	//batches that strip shorter than they list are written as strips, each batch's run follows the last
+	std::vector<KmdBatch> ranges = geo.batches;
+	std::vector<bool> stripped(ranges.size(), false);
+	std::vector<uint32_t> stripIndices;
+
+	if (options.strips) {
+		std::vector<uint32_t> strip;
+
+		for (int b = 0; b < ranges.size(); b++) {
+			stripped[b] = stripKmdBatch(geo, geo.batches[b], strip);
+			auto first = geo.indices.begin() + ranges[b].firstIndex;
+			if (!stripped[b]) strip.assign(first, first + ranges[b].numIndices);
+
+			ranges[b].firstIndex = stripIndices.size();
+			ranges[b].numIndices = strip.size();
+			stripIndices.insert(stripIndices.end(), strip.begin(), strip.end());
+		}
+	}
+
+	const std::vector<uint32_t>& allIndices = options.strips ? stripIndices : geo.indices;
+	size_t numVertex = geo.weights.size();
+	bool shortIndices = numVertex <= 0xFFFF;
+	int indexView;
+
+	if (shortIndices) {
+		std::vector<uint16_t> indices(allIndices.begin(), allIndices.end());
+		indexView = addBufferView(indices.data(), indices.size() * 2, 0, GLTF_ELEMENT_ARRAY_BUFFER);
+	} else {
+		indexView = addBufferView(allIndices.data(), allIndices.size() * 4, 0, GLTF_ELEMENT_ARRAY_BUFFER);
+	}
+
+	std::string primitives;
+	for (int b = 0; b < geo.batches.size(); b++) {
+		const KmdBatch& batch = geo.batches[b];
+		size_t byteOffset = ranges[b].firstIndex * (shortIndices ? 2 : 4);
+		int indices = addAccessor(indexView, byteOffset, shortIndices ? GLTF_UNSIGNED_SHORT : GLTF_UNSIGNED_INT, false, ranges[b].numIndices, "SCALAR");
+
+		int page = atlas && !geo.batchPages.empty() ? geo.batchPages[b] : -1;
+		int material;
+
+		if (page > -1) {
+			if (!pageMaterials.count(page)) pageMaterials[page] = addMaterial("atlas_" + std::to_string(page), &atlas->pages[page]);
+			material = pageMaterials[page];
+		} else {
+			material = addMaterial(batch.strcode, loadImage);
+		}
+
+		if (!primitives.empty()) primitives += ",";
+		primitives += "{\"attributes\":{" + attributes + "},\"indices\":" + std::to_string(indices) + ",\"material\":" + std::to_string(material);
+		primitives += stripped[b] ? ",\"mode\":" + std::to_string(GLTF_TRIANGLE_STRIP) + "}" : "}";
+	}
+
+	int mesh = meshes.add("{\"name\":" + str(name) + ",\"primitives\":[" + primitives + "]}");
+	meshInstances[instance] = mesh;
+	return mesh;
+}
+
+int GltfWriter::addModel(const std::string& name, const KmdView& kmd, const std::vector<KmdGeometry>& geometry, const GltfImageLoader& loadImage, const TextureAtlas* atlas) {
+	std::vector<const KmdGeometry*> meshGeometry;
+	for (const KmdGeometry& geo : geometry) meshGeometry.push_back(&geo);
+
+	return addModel(name, kmd, meshGeometry, loadImage, atlas);
+}
+
+//joints named and placed like addModel's, with nothing drawn on them
+int GltfWriter::addSkeleton(const std::string& name, const KmdSkeleton* skeleton, int numJoints) {
+	if (skeleton) numJoints = skeleton->numBones();
+	int jointBase = nodes.count;
+
+	std::vector<std::vector<int>> children(numJoints);
+	std::vector<int> roots;
+
+	for (int i = 0; i < numJoints; i++) {
+		int parent = skeleton ? skeleton->parents[i] : -1;
+		parent > -1 ? children[parent].push_back(jointBase + i) : roots.push_back(jointBase + i);
+	}
+
+	for (int i = 0; i < numJoints; i++) {
+		std::string node = "{\"name\":" + str("bone_" + std::to_string(i));
+
+		if (skeleton) {
+			float translation[3] = { skeleton->localX[i], skeleton->localY[i], skeleton->localZ[i] };
+			node += ",\"translation\":" + floatList(translation, 3);
+		}
+
+		if (!children[i].empty()) node += ",\"children\":" + intList(children[i]);
+		nodes.add(node + "}");
+	}
+
+	int root = nodes.add("{\"name\":" + str(name) + ",\"children\":" + intList(roots) + "}");
+	sceneNodes.push_back(root);
+
+	models.push_back({ jointBase, numJoints });
+	return models.size() - 1;
+}
+
+//MSFT_lod nodes for each lod follow the node they stand in for and stay out of the scene. coverage halves
+//with each level, the last level is never culled
+int GltfWriter::addMeshNode(const std::string& name, int mesh, const std::vector<int>& lods, int skin) {
+	std::string skinRef = skin > -1 ? ",\"skin\":" + std::to_string(skin) : "";
+	std::string node = "{\"name\":" + str(name) + ",\"mesh\":" + std::to_string(mesh) + skinRef;
+
+	if (!lods.empty()) {
+		std::vector<int> ids;
+		std::vector<float> coverage;
+
+		for (int i = 0; i < lods.size(); i++) {
+			ids.push_back(nodes.count + 1 + i);
+			coverage.push_back(0.5f / (1 << i));
+		}
+
+		coverage.push_back(0.0f);
+		node += ",\"extensions\":{\"MSFT_lod\":{\"ids\":" + intList(ids) + "}},\"extras\":{\"MSFT_screencoverage\":" + floatList(coverage.data(), coverage.size()) + "}";
+		usesLod = true;
+	}
+
+	int index = nodes.add(node + "}");
+
+	for (int i = 0; i < lods.size(); i++) {
+		nodes.add("{\"name\":" + str(name + "_lod" + std::to_string(i + 1)) + ",\"mesh\":" + std::to_string(lods[i]) + skinRef + "}");
+	}
+
+	return index;
+}
+
+//kmd meshes double as bones, so every mesh becomes a joint node. boneless models keep
+//their meshes on those nodes, skinned ones put model space meshes on nodes of their own
+int GltfWriter::addModel(const std::string& name, const KmdView& kmd, const std::vector<const KmdGeometry*>& geometry, const GltfImageLoader& loadImage, const TextureAtlas* atlas) {
+	KmdSkeleton skeleton;
+	buildKmdSkeleton(kmd, skeleton);
+	int numJoints = skeleton.numBones();
+	int jointBase = nodes.count;
+	bool skinned = kmd.numBones() > 0;
+
+	std::vector<std::vector<int>> children(numJoints);
+	std::vector<int> roots;
+
+	for (int i = 0; i < numJoints; i++) {
+		int parent = skeleton.parents[i];
+		parent > -1 ? children[parent].push_back(jointBase + i) : roots.push_back(jointBase + i);
+	}
+
+	const float zero[3] = {};
+	std::vector<int> meshIdx(numJoints, -1);
+	std::vector<std::vector<int>> lodIdx(numJoints);
+
+	for (int i = 0; i < numJoints; i++) {
+		float origin[3];
+		skeleton.worldTranslation(i, origin);
+		std::string meshName = name + "_" + std::to_string(i);
+		meshIdx[i] = addMesh(meshName, *geometry[i], skinned ? origin : zero, skinned, loadImage, atlas);
+		if (meshIdx[i] < 0) continue;
+
+		for (int j = 0; j < geometry[i]->lods.size(); j++) {
+			int lod = addMesh(meshName + "_lod" + std::to_string(j + 1), geometry[i]->lods[j], skinned ? origin : zero, skinned, loadImage, atlas);
+			if (lod > -1) lodIdx[i].push_back(lod);
+		}
+	}
+
+	//boneless meshes with lods go on a child of their joint, the lod nodes stand in for that child alone
+	std::vector<int> lodParents;
+	int nextNode = jointBase + numJoints;
+
+	for (int i = 0; i < numJoints; i++) {
+		float translation[3] = { skeleton.localX[i], skeleton.localY[i], skeleton.localZ[i] };
+		std::vector<int> nodeChildren = children[i];
+		bool meshNode = !skinned && meshIdx[i] > -1;
+
+		if (meshNode && !lodIdx[i].empty()) {
+			nodeChildren.push_back(nextNode);
+			nextNode += 1 + lodIdx[i].size();
+			lodParents.push_back(i);
+			meshNode = false;
+		}
+
+		std::string node = "{\"name\":" + str("bone_" + std::to_string(i)) + ",\"translation\":" + floatList(translation, 3);
+		if (!nodeChildren.empty()) node += ",\"children\":" + intList(nodeChildren);
+		if (meshNode) node += ",\"mesh\":" + std::to_string(meshIdx[i]);
+		nodes.add(node + "}");
+	}
+
+	for (int i : lodParents) {
+		addMeshNode(name + "_" + std::to_string(i), meshIdx[i], lodIdx[i], -1);
+	}
+
+	if (skinned) {
+		std::vector<float> inverseBind;
+		skeleton.inverseBindMatrices(inverseBind);
+
+		int ibm = addAccessor(addBufferView(inverseBind.data(), inverseBind.size() * 4, 0, 0), 0, GLTF_FLOAT, false, numJoints, "MAT4");
+
+		std::vector<int> joints;
+		for (int i = 0; i < numJoints; i++) joints.push_back(jointBase + i);
+		int skin = skins.add("{\"inverseBindMatrices\":" + std::to_string(ibm) + ",\"joints\":" + intList(joints) + "}");
+
+		for (int i = 0; i < numJoints; i++) {
+			if (meshIdx[i] < 0) continue;
+			roots.push_back(addMeshNode(name + "_" + std::to_string(i), meshIdx[i], lodIdx[i], skin));
+		}
+	}
+
+	int root = nodes.add("{\"name\":" + str(name) + ",\"children\":" + intList(roots) + "}");
+	sceneNodes.push_back(root);
+
+	models.push_back({ jointBase, numJoints });
+	return models.size() - 1;
+}
+
+//gltf needs strictly increasing key times, a repeated frame keeps its last key
+template <typename Key>
+static
+std::vector<Key> uniqueKeys(const std::vector<Key>& keys) {
+	std::vector<Key> out;
+
+	for (const Key& key : keys) {
+		if (!out.empty() && out.back().keyframe == key.keyframe) {
+			out.back() = key;
+		} else if (out.empty() || out.back().keyframe < key.keyframe) {
+			out.push_back(key);
+		}
+	}
+
+	return out;
+}
+
+int GltfWriter::addMotions(int model, const uint8_t* oar, int size) {
+	if (model < 0 || model >= models.size() || !validateOar(oar, size)) return 0;
+	if (oarNumJoints(oar) > models[model].numJoints) return 0;
+
+	int added = 0;
+	OarMotion motion;
+
+	for (int m = 0; m < oarNumMotion(oar); m++) {
+		if (decodeOarMotion(oar, size, m, motion) && addMotion(model, motion, "motion_" + std::to_string(m))) added++;
+	}
+
+	releaseOarMotion(motion);
+	return added;
+}
+
+bool GltfWriter::addMotion(int model, const OarMotion& motion, const std::string& name) {
+	if (model < 0 || model >= models.size() || motion.rotation.size() > models[model].numJoints) return false;
+
+	const ModelInfo& info = models[model];
+	std::string samplers, channels;
+	int numSamplers = 0;
+
+	auto addChannel = [&](const std::vector<float>& times, const std::vector<float>& values, const char* type, int node, const char* targetPath) {
+		float tmin = times.front();
+		float tmax = times.back();
+
+		int input = addAccessor(addBufferView(times.data(), times.size() * 4, 0, 0), 0, GLTF_FLOAT, false, times.size(), "SCALAR", &tmin, &tmax);
+		int output = addAccessor(addBufferView(values.data(), values.size() * 4, 0, 0), 0, GLTF_FLOAT, false, times.size(), type);
+
+		if (numSamplers) {
+			samplers += ",";
+			channels += ",";
+		}
+
+		samplers += "{\"input\":" + std::to_string(input) + ",\"output\":" + std::to_string(output) + ",\"interpolation\":\"LINEAR\"}";
+		channels += "{\"sampler\":" + std::to_string(numSamplers++) + ",\"target\":{\"node\":" + std::to_string(node) + ",\"path\":" + str(targetPath) + "}}";
+	};
+
+	std::vector<float> times, values;
+
+	std::vector<OarMoveKey> move = uniqueKeys(motion.move);
+	if (!move.empty()) {
+		for (const OarMoveKey& key : move) {
+			times.push_back(key.keyframe / g_oarFrameRate);
+			values.insert(values.end(), { key.x, key.y, key.z });
+		}
+
+		addChannel(times, values, "VEC3", info.jointBase, "translation");
+	}
+
+	for (int j = 0; j < motion.rotation.size(); j++) {
+		std::vector<OarRotKey> rot = uniqueKeys(motion.rotation[j]);
+		if (rot.empty()) continue;
+
+		times.clear();
+		values.clear();
+
+		for (const OarRotKey& key : rot) {
+			times.push_back(key.keyframe / g_oarFrameRate);
+			values.insert(values.end(), { key.x, key.y, key.z, key.w });
+		}
+
+		addChannel(times, values, "VEC4", info.jointBase + j, "rotation");
+	}
+
+	if (!numSamplers) return false;
+
+	animations.add("{\"name\":" + str(name) + ",\"samplers\":[" + samplers + "],\"channels\":[" + channels + "]}");
+	return true;
+}
+
+bool GltfWriter::writeJson(FILE* f) {
+	std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"mgs_kmd\"}";
+
+	std::string used;
+	if (materials.count) used += ",\"KHR_materials_unlit\"";
+	if (usesQuantization) used += ",\"KHR_mesh_quantization\"";
+	if (usesLod) used += ",\"MSFT_lod\"";
+	if (!used.empty()) json += ",\"extensionsUsed\":[" + used.substr(1) + "]";
+	if (usesQuantization) json += ",\"extensionsRequired\":[\"KHR_mesh_quantization\"]";
+
+	json += ",\"scene\":0,\"scenes\":[{\"nodes\":" + intList(sceneNodes) + "}]";
+
+	std::pair<const char*, JsonArray*> arrays[] = {
+		{ "nodes", &nodes }, { "meshes", &meshes }, { "skins", &skins }, { "accessors", &accessors },
+		{ "bufferViews", &bufferViews }, { "materials", &materials }, { "textures", &textures },
+		{ "images", &images }, { "animations", &animations },
+	};
+
+	for (auto& array : arrays) {
+		if (array.second->count) json += ",\"" + std::string(array.first) + "\":[" + array.second->body + "]";
+	}
+
+	//a buffer must hold at least one byte, a file with nothing streamed has none
+	if (binSize) {
+		std::string buffer = "{\"byteLength\":" + std::to_string(binSize);
+		if (!options.binary) buffer += ",\"uri\":" + str(std::filesystem::u8path(binPath).filename().u8string());
+		json += ",\"buffers\":[" + buffer + "}]";
+	}
+	json += "}";
+
+	//glb chunks are padded to 4 bytes, spaces are valid json padding
+	if (options.binary) json.append((4 - json.size() % 4) % 4, ' ');
+
+	if (options.binary) {
+		uint32_t chunk[2] = { (uint32_t)json.size(), 0x4E4F534A };
+		uint32_t binChunk[2] = { (uint32_t)((binSize + 3) & ~3), 0x004E4942 };
+		uint32_t header[3] = { 0x46546C67, 2, (uint32_t)(12 + 8 + json.size() + (binSize ? 8 + binChunk[0] : 0)) };
+
+		fwrite(header, 4, 3, f);
+		fwrite(chunk, 4, 2, f);
+		fwrite(json.data(), 1, json.size(), f);
+		if (binSize) fwrite(binChunk, 4, 2, f);
+	} else {
+		fwrite(json.data(), 1, json.size(), f);
+	}
+
+	return !ferror(f);
+}
+
+//json first, then the bin stream copied over in blocks
+bool GltfWriter::writeGlb() {
+	FILE* out = fopen(path.c_str(), "wb");
+	if (!out) return false;
+
+	bool ok = writeJson(out);
+
+	FILE* in = fopen(binPath.c_str(), "rb");
+	std::vector<uint8_t> block(1 << 20);
+	size_t n;
+
+	while (in && (n = fread(block.data(), 1, block.size(), in)) > 0) {
+		fwrite(block.data(), 1, n, out);
+	}
+
+	static const uint8_t pad[4] = {};
+	fwrite(pad, 1, (4 - binSize % 4) % 4, out);
+
+	ok = ok && in && !ferror(out);
+	if (in) fclose(in);
+	fclose(out);
+	remove(binPath.c_str());
+	return ok;
+}
+
+bool GltfWriter::finish() {
+	if (!bin) return false;
+
+	bool ok = !ferror(bin);
+	fclose(bin);
+	bin = NULL;
+
+	if (options.binary) return writeGlb() && ok;
+
+	FILE* out = fopen(path.c_str(), "wb");
+	if (!out) return false;
+
+	ok = writeJson(out) && ok;
+	fclose(out);
+	if (!binSize) remove(binPath.c_str());
+	return ok;
+}
\ No newline at end of file
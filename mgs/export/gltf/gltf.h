@@ -0,0 +1,80 @@
+#pragma once
+#include <map>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <functional>
+#include "../../model/kmd/kmdgeometry.h"
+#include "../../model/kmd/kmdskeleton.h"
+#include "../../motion/oar/oarmotion.h"
+#include "../../texture/pcx/pcx.h"
+#include "../../texture/atlas/atlas.h"
+
+struct GltfOptions {
+	bool binary = true;     //single .glb, otherwise .gltf with a .bin beside it
+	bool quantized = false; //KHR_mesh_quantization accessors where the kmd data fits
+	bool strips = false;    //triangle strips for batches they store in fewer indices than a list
+};
+
+typedef std::function<bool(uint16_t strcode, PcxImage& image)> GltfImageLoader;
+
+struct JsonArray {
+	std::string body;
+	int count = 0;
+
+	int add(const std::string& item);
+};
+
+//buffers are streamed to disk as they are added, only the json text stays in memory
+class GltfWriter {
+public:
+	GltfWriter(const std::string& path, const GltfOptions& options);
+	~GltfWriter();
+
+	bool isOpen() const;
+
+	//returns the model index used by addMotions. batches applyAtlas moved onto a page use that page's material,
+	//models added to one file share one atlas
+	int addModel(const std::string& name, const KmdView& kmd, const std::vector<KmdGeometry>& geometry, const GltfImageLoader& loadImage, const TextureAtlas* atlas = NULL);
+	//geometry shared between models is written once, every node placing it refers to the same mesh.
+	//a mesh's lods are written as MSFT_lod levels of the node drawing it
+	int addModel(const std::string& name, const KmdView& kmd, const std::vector<const KmdGeometry*>& geometry, const GltfImageLoader& loadImage, const TextureAtlas* atlas = NULL);
+	//joints for motions to play on without a mesh. with no skeleton there are numJoints of them, all at the root
+	int addSkeleton(const std::string& name, const KmdSkeleton* skeleton, int numJoints);
+	int addMotions(int model, const uint8_t* oar, int size);
+	//false if the motion has more tracks than the model has joints, or no keys at all
+	bool addMotion(int model, const OarMotion& motion, const std::string& name);
+	bool finish();
+private:
+	struct ModelInfo {
+		int jointBase;
+		int numJoints;
+	};
+
+	int addBufferView(const void* data, size_t size, int stride, int target);
+	int addAccessor(int bufferView, size_t byteOffset, int componentType, bool normalized, size_t count, const char* type, const float* min = NULL, const float* max = NULL);
+	int addMaterial(const std::string& name, const PcxImage* image);
+	int addMaterial(uint16_t strcode, const GltfImageLoader& loadImage);
+	int addImage(const PcxImage& image);
+	int addMesh(const std::string& name, const KmdGeometry& geo, const float* offset, bool skinned, const GltfImageLoader& loadImage, const TextureAtlas* atlas);
+	int addMeshNode(const std::string& name, int mesh, const std::vector<int>& lods, int skin);
+	void addAttributes(const KmdGeometry& geo, const float* offset, bool skinned, std::string& attributes);
+	bool writeGlb();
+	bool writeJson(FILE* f);
+
+	std::string path;
+	std::string binPath;
+	GltfOptions options;
+	FILE* bin;
+	size_t binSize;
+
+	JsonArray nodes, meshes, skins, accessors, bufferViews, materials, textures, images, animations;
+	std::vector<int> sceneNodes;
+	std::map<uint16_t, int> materialIdx;
+	std::map<int, int> pageMaterials;
+	std::map<std::tuple<const KmdGeometry*, bool, float, float, float>, int> meshInstances;
+	std::vector<ModelInfo> models;
+	bool usesQuantization;
+	bool usesLod;
+};
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "obj.h"
+#include <stdio.h>
+#include <algorithm>
+#include "../../common/util.h"
+#include "../../model/kmd/kmdskeleton.h"
+#include "../../model/kmd/kmdtopology.h"
+
+std::vector<uint16_t> usedStrcodes(const std::vector<KmdGeometry>& geometry) {
+	std::vector<uint16_t> strcodes;
+
+	for (const KmdGeometry& geo : geometry) {
+		for (const KmdBatch& batch : geo.batches) {
+			strcodes.push_back(batch.strcode);
+		}
+	}
+
+	std::sort(strcodes.begin(), strcodes.end());
+	strcodes.erase(std::unique(strcodes.begin(), strcodes.end()), strcodes.end());
+	return strcodes;
+}
+
+bool writeObj(const std::string& path, const std::string& mtlName, const KmdView& kmd, const std::vector<KmdGeometry>& geometry, bool quads) {
+	FILE* f = fopen(path.c_str(), "w");
+	if (!f) return false;
+
+	fprintf(f, "mtllib %s\n", mtlName.c_str());
+	uint32_t base = 1;
+
+	KmdSkeleton skeleton;
+	buildKmdSkeleton(kmd, skeleton);
+
+	for (int i = 0; i < geometry.size(); i++) {
+		const KmdGeometry& geo = geometry[i];
+		int numVertex = geo.weights.size();
+		if (geo.quantized || !numVertex) continue;
+
+		float origin[3];
+		skeleton.worldTranslation(i, origin);
+		fprintf(f, "g mesh_%d\n", i);
+
+		for (int v = 0; v < numVertex; v++) {
+			const float* p = &geo.positions[v * 3];
+			fprintf(f, "v %g %g %g\n", p[0] + origin[0], p[1] + origin[1], p[2] + origin[2]);
+		}
+
+		for (int v = 0; v < numVertex; v++) {
+			const float* n = &geo.normals[v * 3];
+			fprintf(f, "vn %g %g %g\n", n[0], n[1], n[2]);
+		}
+
+		//obj puts the uv origin at the bottom left
+		for (int v = 0; v < numVertex; v++) {
+			const float* t = &geo.uvs[v * 2];
+			fprintf(f, "vt %g %g\n", t[0], 1.0f - t[1]);
+		}
+
+		std::vector<KmdPolygon> polygons;
+
+		for (const KmdBatch& batch : geo.batches) {
+			fprintf(f, "usemtl %s\n", intToHexString(batch.strcode).c_str());
+
+			if (quads) {
+				polygons.clear();
+				kmdBatchPolygons(geo, batch, polygons);
+
+				for (const KmdPolygon& polygon : polygons) {
+					fprintf(f, "f");
+					for (int c = 0; c < polygon.numCorners; c++) {
+						uint32_t v = polygon.v[c] + base;
+						fprintf(f, " %u/%u/%u", v, v, v);
+					}
+					fprintf(f, "\n");
+				}
+				continue;
+			}
+
+			for (uint32_t x = batch.firstIndex; x < batch.firstIndex + batch.numIndices; x += 3) {
+				uint32_t a = geo.indices[x + 0] + base;
+				uint32_t b = geo.indices[x + 1] + base;
+				uint32_t c = geo.indices[x + 2] + base;
+				fprintf(f, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+			}
+		}
+
+		base += numVertex;
+	}
+
+	bool ok = !ferror(f);
+	fclose(f);
+	return ok;
+}
+
+bool writeMtl(const std::string& path, const std::vector<uint16_t>& strcodes, const std::string& texExt) {
+	FILE* f = fopen(path.c_str(), "w");
+	if (!f) return false;
+
+	for (uint16_t strcode : strcodes) {
+		std::string name = intToHexString(strcode);
+		fprintf(f, "newmtl %s\nKd 1 1 1\nmap_Kd %s%s\n\n", name.c_str(), name.c_str(), texExt.c_str());
+	}
+
+	bool ok = !ferror(f);
+	fclose(f);
+	return ok;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../../model/kmd/kmdgeometry.h"
+
+//materials are named after their strcode and point at <strcode><texExt>. quads writes faces as the kmd authored them
+bool writeObj(const std::string& path, const std::string& mtlName, const KmdView& kmd, const std::vector<KmdGeometry>& geometry, bool quads = false);
+bool writeMtl(const std::string& path, const std::vector<uint16_t>& strcodes, const std::string& texExt = ".tga");
+
+std::vector<uint16_t> usedStrcodes(const std::vector<KmdGeometry>& geometry);
\ No newline at end of file
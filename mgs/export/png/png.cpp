@@ -0,0 +1,128 @@
+#include "png.h"
+
+struct CrcTable {
+	uint32_t entries[256];
+
+	CrcTable() {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			entries[i] = c;
+		}
+	}
+};
+
+static
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+	static const CrcTable crcTable;
+	const uint32_t* table = crcTable.entries;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+static
+void putU32BE(std::vector<uint8_t>& out, uint32_t v) {
+	out.push_back(v >> 24);
+	out.push_back(v >> 16);
+	out.push_back(v >> 8);
+	out.push_back(v);
+}
+
+static
+void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+	putU32BE(out, data.size());
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	putU32BE(out, crc32(&out[start], out.size() - start));
+}
+
+//zlib stream of stored blocks
+static
+std::vector<uint8_t> storeZlib(const std::vector<uint8_t>& raw) {
+	std::vector<uint8_t> z = { 0x78, 0x01 };
+	size_t pos = 0;
+
+	do {
+		size_t len = raw.size() - pos < 0xFFFF ? raw.size() - pos : 0xFFFF;
+		bool last = pos + len == raw.size();
+
+		z.push_back(last ? 1 : 0);
+		z.push_back(len & 0xFF);
+		z.push_back(len >> 8);
+		z.push_back(~len & 0xFF);
+		z.push_back((~len >> 8) & 0xFF);
+		z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+		pos += len;
+	} while (pos < raw.size());
+
+	uint32_t a = 1, b = 0;
+	for (uint8_t c : raw) {
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	putU32BE(z, (b << 16) | a);
+	return z;
+}
+
+static
+std::vector<uint8_t> pngHeader(int width, int height, uint8_t colorType) {
+	std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	std::vector<uint8_t> ihdr;
+	putU32BE(ihdr, width);
+	putU32BE(ihdr, height);
+	ihdr.insert(ihdr.end(), { 8, colorType, 0, 0, 0 });
+	putChunk(png, "IHDR", ihdr);
+	return png;
+}
+
+//every row uses filter 0
+static
+void putRows(std::vector<uint8_t>& png, const uint8_t* data, size_t rowSize, int height) {
+	std::vector<uint8_t> raw;
+	raw.reserve((rowSize + 1) * height);
+
+	for (int y = 0; y < height; y++) {
+		raw.push_back(0);
+		raw.insert(raw.end(), &data[y * rowSize], &data[y * rowSize] + rowSize);
+	}
+
+	putChunk(png, "IDAT", storeZlib(raw));
+	putChunk(png, "IEND", {});
+}
+
+std::vector<uint8_t> encodePng(const uint8_t* rgba, int width, int height) {
+	std::vector<uint8_t> png = pngHeader(width, height, 6);
+	putRows(png, rgba, width * 4, height);
+	return png;
+}
+
+std::vector<uint8_t> encodePngIndexed(const uint8_t* indices, const uint8_t* palette, int width, int height) {
+	std::vector<uint8_t> png = pngHeader(width, height, 3);
+
+	std::vector<uint8_t> plte;
+	std::vector<uint8_t> trns;
+	bool used[256] = {};
+	for (size_t i = 0; i < (size_t)width * height; i++) used[indices[i]] = true;
+
+	//entries no pixel uses count as opaque, trns ends at the last one that isn't
+	for (int i = 0; i < 256; i++) {
+		plte.insert(plte.end(), &palette[i * 4], &palette[i * 4] + 3);
+		trns.push_back(used[i] ? palette[i * 4 + 3] : 0xFF);
+	}
+
+	while (!trns.empty() && trns.back() == 0xFF) trns.pop_back();
+
+	putChunk(png, "PLTE", plte);
+	if (!trns.empty()) putChunk(png, "tRNS", trns);
+
+	putRows(png, indices, width, height);
+	return png;
+}
\ No newline at end of file
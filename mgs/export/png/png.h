@@ -0,0 +1,9 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <inttypes.h>
+
+//written with stored deflate blocks, size is traded for needing no zlib
+std::vector<uint8_t> encodePng(const uint8_t* rgba, int width, int height);
+//8-bit indexed, palette is 256 rgba entries. trns is only written when an entry isn't opaque
+std::vector<uint8_t> encodePngIndexed(const uint8_t* indices, const uint8_t* palette, int width, int height);
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "kmd.h"
+
+static
+bool inRange(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size) {
+	return offset <= size && count * stride <= size - offset;
+}
+
+static
+bool validateMesh(const KmdMesh* mesh, int meshNum, uint32_t numMesh, uint64_t size) {
+	if (mesh->parent < -1 || mesh->parent >= (int64_t)numMesh || mesh->parent == meshNum) return false;
+
+	if (!inRange(mesh->vertexIndexOffset, mesh->numVertex,  sizeof(KmdVert),  size)) return false;
+	if (!inRange(mesh->normalIndexOffset, mesh->numNormals, sizeof(KmdNVert), size)) return false;
+	if (!inRange(mesh->faceIndexOffset,   mesh->numFace,    sizeof(KmdFace),  size)) return false;
+	if (!inRange(mesh->normalFaceOffset,  mesh->numFace,    sizeof(KmdFace),  size)) return false;
+	if (!inRange(mesh->uvOffset,          mesh->numFace,    sizeof(KmdUV) * 4, size)) return false;
+	if (!inRange(mesh->materialOffset,    mesh->numFace,    sizeof(uint16_t), size)) return false;
+
+	return true;
+}
+
+//header and per mesh table checks only, face data itself is never touched
+bool validateKmd(const uint8_t* data, int size) {
+	if (!data || size < (int)sizeof(KmdHeader)) return false;
+
+	const KmdHeader* header = (const KmdHeader*)data;
+	if (!header->numMesh || header->numBones > header->numMesh) return false;
+	if (!inRange(sizeof(KmdHeader), header->numMesh, sizeof(KmdMesh), size)) return false;
+
+	const KmdMesh* mesh = (const KmdMesh*)&data[sizeof(KmdHeader)];
+
+	for (uint32_t i = 0; i < header->numMesh; i++) {
+		if (!validateMesh(&mesh[i], i, header->numMesh, size))
+			return false;
+	}
+
+	return true;
+}
+
+KmdView::KmdView(const uint8_t* data, int size) {
+	this->kmdData = data;
+	this->valid = validateKmd(data, size);
+}
+
+template <typename T>
+Span<const T> KmdView::at(uint32_t offset, uint32_t count) const {
+	if (!valid) return {};
+	return { (const T*)&kmdData[offset], count };
+}
+
+bool KmdView::isValid() const {
+	return valid;
+}
+
+uint32_t KmdView::numBones() const {
+	return valid ? header()->numBones : 0;
+}
+
+uint32_t KmdView::numMesh() const {
+	return valid ? header()->numMesh : 0;
+}
+
+const KmdHeader* KmdView::header() const {
+	return (const KmdHeader*)kmdData;
+}
+
+Span<const KmdMesh> KmdView::meshes() const {
+	return at<KmdMesh>(sizeof(KmdHeader), numMesh());
+}
+
+Span<const KmdVert> KmdView::vertices(int meshIdx) const {
+	const KmdMesh& mesh = meshes()[meshIdx];
+	return at<KmdVert>(mesh.vertexIndexOffset, mesh.numVertex);
+}
+
+Span<const KmdNVert> KmdView::normals(int meshIdx) const {
+	const KmdMesh& mesh = meshes()[meshIdx];
+	return at<KmdNVert>(mesh.normalIndexOffset, mesh.numNormals);
+}
+
+//4 indices per face, a triangle repeats its last index
+Span<const uint8_t> KmdView::faceIndices(int meshIdx) const {
+	const KmdMesh& mesh = meshes()[meshIdx];
+	return at<uint8_t>(mesh.faceIndexOffset, mesh.numFace * 4);
+}
+
+//4 indices per face, only the low 7 bits index the normal
+Span<const uint8_t> KmdView::normalFaceIndices(int meshIdx) const {
+	const KmdMesh& mesh = meshes()[meshIdx];
+	return at<uint8_t>(mesh.normalFaceOffset, mesh.numFace * 4);
+}
+
+Span<const KmdUV> KmdView::uvs(int meshIdx) const {
+	const KmdMesh& mesh = meshes()[meshIdx];
+	return at<KmdUV>(mesh.uvOffset, mesh.numFace * 4);
+}
+
+Span<const uint16_t> KmdView::materials(int meshIdx) const {
+	const KmdMesh& mesh = meshes()[meshIdx];
+	return at<uint16_t>(mesh.materialOffset, mesh.numFace);
+}
\ No newline at end of file
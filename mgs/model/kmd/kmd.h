@@ -1,5 +1,6 @@
 #pragma once
 #include <inttypes.h>
+#include "../../common/span.h"
 
 struct KmdVert {
 	int16_t x;
@@ -57,4 +58,32 @@ struct KmdMesh {
 	uint32_t uvOffset;
 	uint32_t materialOffset;
 	uint32_t pad;
+};
+
+bool validateKmd(const uint8_t* data, int size);
+
+//non owning view over a kmd buffer, validated once on construction
+class KmdView {
+public:
+	KmdView(const uint8_t* data, int size);
+
+	bool isValid() const;
+	uint32_t numBones() const;
+	uint32_t numMesh() const;
+
+	const KmdHeader* header() const;
+	Span<const KmdMesh> meshes() const;
+
+	Span<const KmdVert>  vertices(int meshIdx) const;
+	Span<const KmdNVert> normals(int meshIdx) const;
+	Span<const uint8_t>  faceIndices(int meshIdx) const;
+	Span<const uint8_t>  normalFaceIndices(int meshIdx) const;
+	Span<const KmdUV>    uvs(int meshIdx) const;
+	Span<const uint16_t> materials(int meshIdx) const;
+private:
+	template <typename T>
+	Span<const T> at(uint32_t offset, uint32_t count) const;
+
+	const uint8_t* kmdData;
+	bool valid;
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "kmdatlas.h"
+#include <map>
+
+//slot of every batch off the atlas, their vertices keep the uvs they have
+static const int NO_RECT = -2;
+
+typedef std::map<std::pair<uint32_t, int>, uint32_t> VertexCopies;
+
+//welded vertices can be shared by batches on different rects, those get one copy per rect
+static
+uint32_t remapVertex(KmdGeometry& geo, std::vector<int>& vertexRect, VertexCopies& copies, uint32_t vertex, int rect) {
+	if (vertexRect[vertex] == rect || vertexRect[vertex] == -1) {
+		vertexRect[vertex] = rect;
+		return vertex;
+	}
+
+	auto it = copies.emplace(std::make_pair(vertex, rect), (uint32_t)geo.weights.size());
+	if (!it.second) return it.first->second;
+
+	uint32_t copy = it.first->second;
+	vertexRect.push_back(rect);
+	geo.weights.push_back(geo.weights[vertex]);
+	geo.bones.push_back(geo.bones[vertex]);
+	geo.uvs.insert(geo.uvs.end(), { geo.uvs[vertex * 2], geo.uvs[vertex * 2 + 1] });
+
+	if (geo.quantized) {
+		for (int c = 0; c < 3; c++) geo.shortPositions.push_back(geo.shortPositions[vertex * 3 + c]);
+		for (int c = 0; c < 3; c++) geo.halfNormals.push_back(geo.halfNormals[vertex * 3 + c]);
+	} else {
+		for (int c = 0; c < 3; c++) geo.positions.push_back(geo.positions[vertex * 3 + c]);
+		for (int c = 0; c < 3; c++) geo.normals.push_back(geo.normals[vertex * 3 + c]);
+	}
+
+	return copy;
+}
+
+void applyAtlas(const TextureAtlas& atlas, KmdGeometry& geo) {
+	//byte uvs can't address a page, quantized geometry falls back to float uvs
+	if (geo.quantized && !geo.byteUVs.empty()) {
+		geo.uvs.resize(geo.byteUVs.size() * 2);
+
+		for (size_t i = 0; i < geo.byteUVs.size(); i++) {
+			geo.uvs[i * 2 + 0] = geo.byteUVs[i].tu / 256.0f;
+			geo.uvs[i * 2 + 1] = geo.byteUVs[i].tv / 256.0f;
+		}
+
+		geo.byteUVs.clear();
+	}
+
+	size_t numVertex = geo.weights.size();
+	std::vector<int> vertexRect(numVertex, -1);
+	std::vector<const AtlasRect*> rects;
+	std::vector<int> rectOf(geo.batches.size(), NO_RECT);
+	std::map<uint16_t, int> strcodeRects;
+	VertexCopies copies;
+
+	//one slot per material, so batches sharing it share their vertices too
+	for (int b = 0; b < geo.batches.size(); b++) {
+		auto it = atlas.rects.find(geo.batches[b].strcode);
+		if (it == atlas.rects.end()) continue;
+
+		auto slot = strcodeRects.emplace(it->first, (int)rects.size());
+		if (slot.second) rects.push_back(&it->second);
+		rectOf[b] = slot.first->second;
+	}
+
+	for (int b = 0; b < geo.batches.size(); b++) {
+		const KmdBatch& batch = geo.batches[b];
+
+		for (uint32_t i = batch.firstIndex; i < batch.firstIndex + batch.numIndices; i++) {
+			geo.indices[i] = remapVertex(geo, vertexRect, copies, geo.indices[i], rectOf[b]);
+		}
+	}
+
+	float scale = 1.0f / atlas.pageSize;
+
+	for (size_t v = 0; v < vertexRect.size(); v++) {
+		if (vertexRect[v] < 0) continue;
+
+		const AtlasRect& rect = *rects[vertexRect[v]];
+		geo.uvs[v * 2 + 0] = (rect.x + geo.uvs[v * 2 + 0] * rect.width) * scale;
+		geo.uvs[v * 2 + 1] = (rect.y + geo.uvs[v * 2 + 1] * rect.height) * scale;
+	}
+
+	std::vector<KmdBatch> batches;
+	geo.batchPages.clear();
+
+	for (int b = 0; b < geo.batches.size(); b++) {
+		const KmdBatch& batch = geo.batches[b];
+		int page = rectOf[b] > -1 ? rects[rectOf[b]]->page : -1;
+
+		bool contiguous = !batches.empty() && batches.back().firstIndex + batches.back().numIndices == batch.firstIndex;
+		if (page > -1 && contiguous && geo.batchPages.back() == page) {
+			batches.back().numIndices += batch.numIndices;
+			continue;
+		}
+
+		batches.push_back(batch);
+		geo.batchPages.push_back(page);
+	}
+
+	geo.batches = batches;
+	for (KmdGeometry& lod : geo.lods) applyAtlas(atlas, lod);
+}
\ No newline at end of file
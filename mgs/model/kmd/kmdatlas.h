@@ -0,0 +1,7 @@
+#pragma once
+#include "kmdgeometry.h"
+#include "../../texture/atlas/atlas.h"
+
+//moves uvs into atlas space and fills geo.batchPages, merging neighbouring batches that land on one page.
+//batches whose strcode isn't in the atlas keep their own material. geo's lods are moved along with it
+void applyAtlas(const TextureAtlas& atlas, KmdGeometry& geo);
\ No newline at end of file
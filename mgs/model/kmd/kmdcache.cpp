@@ -0,0 +1,191 @@
+#include "kmdcache.h"
+#include <fstream>
+#include <string.h>
+#include "../../common/hash.h"
+#include "../../common/cachedir.h"
+
+namespace fs = std::filesystem;
+
+static const uint32_t KMDCACHE_MAGIC = 0x434B474D; //MGKC
+static const uint32_t KMDCACHE_VERSION = 3;
+
+KmdCache::KmdCache(const fs::path& dir, uint64_t maxBytes) {
+	this->dir = dir;
+	this->maxBytes = maxBytes;
+	this->totalBytes = 0;
+	this->scanned = false;
+
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+}
+
+uint64_t KmdCache::sourceHash(const uint8_t* kmdData, int dataSize) {
+	return hashBytes(kmdData, dataSize);
+}
+
+fs::path KmdCache::entryPath(uint64_t sourceHash, bool quantized, int lodLevels) {
+	char name[40];
+	char lods[8] = "";
+	if (lodLevels) snprintf(lods, sizeof(lods), "_l%d", lodLevels);
+	snprintf(name, sizeof(name), "%016llx%s%s.kmc", (unsigned long long)sourceHash, quantized ? "_q" : "", lods);
+	return dir / name;
+}
+
+static
+size_t alignUp(size_t offset) {
+	return (offset + 3) & ~(size_t)3;
+}
+
+template <typename T>
+static
+void writeStream(std::vector<uint8_t>& data, const std::vector<T>& stream) {
+	size_t offset = data.size();
+	data.resize(alignUp(offset + stream.size() * sizeof(T)));
+	if (!stream.empty()) memcpy(&data[offset], stream.data(), stream.size() * sizeof(T));
+}
+
+template <typename T>
+static
+bool readStream(const std::vector<uint8_t>& data, size_t& offset, size_t count, std::vector<T>& stream) {
+	size_t size = count * sizeof(T);
+	if (offset > data.size() || size > data.size() - offset) return false;
+
+	stream.resize(count);
+	if (size) memcpy(stream.data(), &data[offset], size);
+	offset = alignUp(offset + size);
+	return true;
+}
+
+static
+bool readMesh(const std::vector<uint8_t>& data, const KmdCacheMesh& mesh, bool quantized, KmdGeometry& geo) {
+	size_t offset = mesh.offset;
+	bool ok = true;
+	geo.quantized = quantized;
+
+	if (quantized) {
+		ok = ok && readStream(data, offset, mesh.numVertex * 3, geo.shortPositions);
+		ok = ok && readStream(data, offset, mesh.numVertex * 3, geo.halfNormals);
+		ok = ok && readStream(data, offset, mesh.numVertex, geo.byteUVs);
+	} else {
+		ok = ok && readStream(data, offset, mesh.numVertex * 3, geo.positions);
+		ok = ok && readStream(data, offset, mesh.numVertex * 3, geo.normals);
+		ok = ok && readStream(data, offset, mesh.numVertex * 2, geo.uvs);
+	}
+
+	ok = ok && readStream(data, offset, mesh.numVertex, geo.weights);
+	ok = ok && readStream(data, offset, mesh.numVertex, geo.bones);
+	ok = ok && readStream(data, offset, mesh.numIndex, geo.indices);
+	ok = ok && readStream(data, offset, mesh.numBatch, geo.batches);
+	if (!ok) return false;
+
+	for (uint32_t& index : geo.indices) {
+		if (index >= mesh.numVertex) return false;
+	}
+
+	for (const KmdBatch& batch : geo.batches) {
+		if (batch.firstIndex > mesh.numIndex || batch.numIndices > mesh.numIndex - batch.firstIndex) return false;
+	}
+
+	return true;
+}
+
+bool KmdCache::find(uint64_t sourceHash, bool quantized, int lodLevels, uint32_t numSourceMesh, std::vector<KmdGeometry>& geometry) {
+	fs::path path = entryPath(sourceHash, quantized, lodLevels);
+	std::ifstream fs(path, std::ios::binary | std::ios::ate);
+	if (!fs) return false;
+
+	std::vector<uint8_t> data((size_t)fs.tellg());
+	fs.seekg(0);
+	if (!fs.read((char*)data.data(), data.size())) return false;
+	if (data.size() < sizeof(KmdCacheHeader)) return false;
+
+	KmdCacheHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != KMDCACHE_MAGIC || header.version != KMDCACHE_VERSION) return false;
+	if (header.sourceHash != sourceHash || header.quantized != quantized) return false;
+	if (header.numSourceMesh != numSourceMesh) return false;
+	if (header.numMesh > (data.size() - sizeof(header)) / sizeof(KmdCacheMesh)) return false;
+
+	geometry.clear();
+
+	//each mesh's entry is followed by numLods entries for its lods
+	for (uint32_t i = 0; i < header.numMesh;) {
+		KmdCacheMesh mesh;
+		memcpy(&mesh, &data[sizeof(header) + i * sizeof(KmdCacheMesh)], sizeof(mesh));
+		if (mesh.numLods > header.numMesh - i - 1) return false;
+
+		geometry.emplace_back();
+		KmdGeometry& geo = geometry.back();
+		if (!readMesh(data, mesh, quantized, geo)) return false;
+
+		geo.lods.resize(mesh.numLods);
+		for (uint32_t j = 0; j < mesh.numLods; j++) {
+			KmdCacheMesh lod;
+			memcpy(&lod, &data[sizeof(header) + (i + 1 + j) * sizeof(KmdCacheMesh)], sizeof(lod));
+			if (lod.numLods || !readMesh(data, lod, quantized, geo.lods[j])) return false;
+		}
+
+		i += 1 + mesh.numLods;
+	}
+
+	if (geometry.size() != numSourceMesh) return false;
+
+	fs.close();
+	touchCacheFile(path);
+	for (const KmdGeometry& geo : geometry) countKmdGeometry(geo);
+	return true;
+}
+
+static
+void writeMesh(std::vector<uint8_t>& data, const KmdGeometry& geo, bool quantized, std::vector<KmdCacheMesh>& meshes) {
+	meshes.push_back({ (uint32_t)geo.weights.size(), (uint32_t)geo.indices.size(), (uint32_t)geo.batches.size(), (uint32_t)geo.lods.size(), data.size() });
+
+	if (quantized) {
+		writeStream(data, geo.shortPositions);
+		writeStream(data, geo.halfNormals);
+		writeStream(data, geo.byteUVs);
+	} else {
+		writeStream(data, geo.positions);
+		writeStream(data, geo.normals);
+		writeStream(data, geo.uvs);
+	}
+
+	writeStream(data, geo.weights);
+	writeStream(data, geo.bones);
+	writeStream(data, geo.indices);
+	writeStream(data, geo.batches);
+}
+
+void KmdCache::store(uint64_t sourceHash, bool quantized, int lodLevels, const std::vector<KmdGeometry>& geometry) {
+	size_t numEntries = 0;
+	for (const KmdGeometry& geo : geometry) numEntries += 1 + geo.lods.size();
+
+	KmdCacheHeader header = {};
+	header.magic = KMDCACHE_MAGIC;
+	header.version = KMDCACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.quantized = quantized;
+	header.numMesh = numEntries;
+	header.numSourceMesh = geometry.size();
+
+	std::vector<KmdCacheMesh> meshes;
+	std::vector<uint8_t> data(sizeof(header) + numEntries * sizeof(KmdCacheMesh));
+
+	for (const KmdGeometry& geo : geometry) {
+		writeMesh(data, geo, quantized, meshes);
+		for (const KmdGeometry& lod : geo.lods) writeMesh(data, lod, quantized, meshes);
+	}
+
+	memcpy(&data[0], &header, sizeof(header));
+	if (!meshes.empty()) memcpy(&data[sizeof(header)], meshes.data(), meshes.size() * sizeof(KmdCacheMesh));
+
+	if (!writeCacheFile(entryPath(sourceHash, quantized, lodLevels), data.data(), data.size())) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	totalBytes += data.size();
+
+	if (!scanned || totalBytes > maxBytes) {
+		totalBytes = trimCacheDir(dir, ".kmc", maxBytes, maxBytes / 4 * 3);
+		scanned = true;
+	}
+}
\ No newline at end of file
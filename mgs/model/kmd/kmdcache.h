@@ -0,0 +1,46 @@
+#pragma once
+#include <mutex>
+#include <filesystem>
+#include "kmdgeometry.h"
+
+//one file per kmd: header, mesh table, then each mesh's welded streams 4 byte aligned
+//in the order positions, normals, uvs, weights, bones, indices, batches. a mesh's lods
+//follow it in the table, numMesh counts them too while numSourceMesh is the kmd's own count
+struct KmdCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t quantized;
+	uint32_t numMesh;
+	uint32_t numSourceMesh;
+	uint32_t pad;
+};
+
+struct KmdCacheMesh {
+	uint32_t numVertex;
+	uint32_t numIndex;
+	uint32_t numBatch;
+	uint32_t numLods;
+	uint64_t offset;
+};
+
+//decoded and welded geometry keyed by the hash of the kmd it came from
+class KmdCache {
+public:
+	KmdCache(const std::filesystem::path& dir, uint64_t maxBytes);
+
+	static uint64_t sourceHash(const uint8_t* kmdData, int dataSize);
+
+	//lodLevels is what buildKmdLods was asked for, so entries made with and without lods don't collide.
+	//an entry only matches a kmd with numSourceMesh meshes, callers index the geometry by kmd mesh
+	bool find(uint64_t sourceHash, bool quantized, int lodLevels, uint32_t numSourceMesh, std::vector<KmdGeometry>& geometry);
+	void store(uint64_t sourceHash, bool quantized, int lodLevels, const std::vector<KmdGeometry>& geometry);
+private:
+	std::filesystem::path entryPath(uint64_t sourceHash, bool quantized, int lodLevels);
+
+	std::filesystem::path dir;
+	uint64_t maxBytes;
+	uint64_t totalBytes;
+	bool scanned;
+	std::mutex mutex;
+};
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "kmdconvert.h"
+#include <string.h>
+#include "../../common/cpu.h"
+
+typedef void (*Short4Kernel)(const int16_t* in, size_t count, float scale, float* out);
+typedef void (*Byte2Kernel)(const uint8_t* in, size_t count, float scale, float* out);
+
+struct ConvertKernels {
+	const char* name;
+	Short4Kernel short4;
+	Byte2Kernel byte2;
+};
+
+static
+void short4Scalar(const int16_t* in, size_t count, float scale, float* out) {
+	for (size_t i = 0; i < count; i++) {
+		out[i * 3 + 0] = in[i * 4 + 0] * scale;
+		out[i * 3 + 1] = in[i * 4 + 1] * scale;
+		out[i * 3 + 2] = in[i * 4 + 2] * scale;
+	}
+}
+
+static
+void byte2Scalar(const uint8_t* in, size_t count, float scale, float* out) {
+	for (size_t i = 0; i < count * 2; i++) {
+		out[i] = in[i] * scale;
+	}
+}
+
+#ifdef MGS_X86
+//each vertex is stored as 4 floats 3 apart so the next store overwrites w,
+//the loop stops one vertex early so the last w never lands past the end
+MGS_TARGET_SSE2 static
+void short4SSE2(const int16_t* in, size_t count, float scale, float* out) {
+	__m128 s = _mm_set1_ps(scale);
+	size_t i = 0;
+
+	for (; i + 3 <= count; i += 2) {
+		__m128i v = _mm_loadu_si128((const __m128i*)&in[i * 4]);
+		__m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+		_mm_storeu_ps(&out[i * 3 + 0], _mm_mul_ps(_mm_cvtepi32_ps(a), s));
+		_mm_storeu_ps(&out[i * 3 + 3], _mm_mul_ps(_mm_cvtepi32_ps(b), s));
+	}
+
+	short4Scalar(&in[i * 4], count - i, scale, &out[i * 3]);
+}
+
+MGS_TARGET_SSE2 static
+void byte2SSE2(const uint8_t* in, size_t count, float scale, float* out) {
+	__m128 s = _mm_set1_ps(scale);
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)&in[i * 2]);
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+
+		_mm_storeu_ps(&out[i * 2 + 0],  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), s));
+		_mm_storeu_ps(&out[i * 2 + 4],  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), s));
+		_mm_storeu_ps(&out[i * 2 + 8],  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), s));
+		_mm_storeu_ps(&out[i * 2 + 12], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), s));
+	}
+
+	byte2Scalar(&in[i * 2], count - i, scale, &out[i * 2]);
+}
+
+MGS_TARGET_AVX2 static
+void short4AVX2(const int16_t* in, size_t count, float scale, float* out) {
+	__m256 s = _mm256_set1_ps(scale);
+	size_t i = 0;
+
+	for (; i + 5 <= count; i += 4) {
+		__m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)&in[i * 4 + 0]));
+		__m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)&in[i * 4 + 8]));
+		__m256 fa = _mm256_mul_ps(_mm256_cvtepi32_ps(a), s);
+		__m256 fb = _mm256_mul_ps(_mm256_cvtepi32_ps(b), s);
+
+		_mm_storeu_ps(&out[i * 3 + 0], _mm256_castps256_ps128(fa));
+		_mm_storeu_ps(&out[i * 3 + 3], _mm256_extractf128_ps(fa, 1));
+		_mm_storeu_ps(&out[i * 3 + 6], _mm256_castps256_ps128(fb));
+		_mm_storeu_ps(&out[i * 3 + 9], _mm256_extractf128_ps(fb, 1));
+	}
+
+	short4SSE2(&in[i * 4], count - i, scale, &out[i * 3]);
+}
+
+MGS_TARGET_AVX2 static
+void byte2AVX2(const uint8_t* in, size_t count, float scale, float* out) {
+	__m256 s = _mm256_set1_ps(scale);
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		for (int j = 0; j < 4; j++) {
+			__m128i v = _mm_loadl_epi64((const __m128i*)&in[i * 2 + j * 8]);
+			__m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+			_mm256_storeu_ps(&out[i * 2 + j * 8], _mm256_mul_ps(f, s));
+		}
+	}
+
+	byte2SSE2(&in[i * 2], count - i, scale, &out[i * 2]);
+}
+
+static
+ConvertKernels selectKernels() {
+	if (cpuFeatures().avx2) return { "avx2", short4AVX2, byte2AVX2 };
+	if (cpuFeatures().sse2) return { "sse2", short4SSE2, byte2SSE2 };
+	return { "scalar", short4Scalar, byte2Scalar };
+}
+#else
+static
+ConvertKernels selectKernels() {
+	return { "scalar", short4Scalar, byte2Scalar };
+}
+#endif
+
+static
+const ConvertKernels& kernels() {
+	static const ConvertKernels k = selectKernels();
+	return k;
+}
+
+void convertVertices(const KmdVert* vertices, size_t count, float scale, float* out) {
+	kernels().short4((const int16_t*)vertices, count, scale, out);
+}
+
+void convertNormals(const KmdNVert* normals, size_t count, float scale, float* out) {
+	kernels().short4((const int16_t*)normals, count, scale, out);
+}
+
+void convertUVs(const KmdUV* uvs, size_t count, float scale, float* out) {
+	kernels().byte2((const uint8_t*)uvs, count, scale, out);
+}
+
+const char* convertKernelName() {
+	return kernels().name;
+}
+
+void packVertices(const KmdVert* vertices, size_t count, int16_t* out) {
+	for (size_t i = 0; i < count; i++) {
+		out[i * 3 + 0] = vertices[i].x;
+		out[i * 3 + 1] = vertices[i].y;
+		out[i * 3 + 2] = vertices[i].z;
+	}
+}
+
+//4.12 values never reach the half denormal or infinity range, so those just clamp
+static
+uint16_t floatToHalf(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, 4);
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = ((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (exponent <= 0) return sign;
+	if (exponent >= 31) return sign | 0x7C00;
+
+	uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000) half++;
+	return half;
+}
+
+void packNormalsHalf(const KmdNVert* normals, size_t count, uint16_t* out) {
+	float scale = 1 / 4096.0f;
+
+	for (size_t i = 0; i < count; i++) {
+		out[i * 3 + 0] = floatToHalf(normals[i].x * scale);
+		out[i * 3 + 1] = floatToHalf(normals[i].y * scale);
+		out[i * 3 + 2] = floatToHalf(normals[i].z * scale);
+	}
+}
\ No newline at end of file
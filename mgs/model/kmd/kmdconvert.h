@@ -0,0 +1,15 @@
+#pragma once
+#include <stddef.h>
+#include "kmd.h"
+
+//bulk int to float kernels, picked once at runtime from avx2, sse2 or scalar
+//vertex kernels write xyz per vertex, w is dropped
+void convertVertices(const KmdVert* vertices, size_t count, float scale, float* out);
+void convertNormals(const KmdNVert* normals, size_t count, float scale, float* out);
+void convertUVs(const KmdUV* uvs, size_t count, float scale, float* out);
+
+//quantized output, xyz int16 positions and 4.12 normals as xyz half floats
+void packVertices(const KmdVert* vertices, size_t count, int16_t* out);
+void packNormalsHalf(const KmdNVert* normals, size_t count, uint16_t* out);
+
+const char* convertKernelName();
\ No newline at end of file
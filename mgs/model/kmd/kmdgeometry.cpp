@@ -0,0 +1,244 @@
+#include "kmdgeometry.h"
+#include "kmdconvert.h"
+#include <string.h>
+#include <unordered_map>
+#include "../../common/hash.h"
+#include "../../common/arena.h"
+#include "../../common/memstats.h"
+
+bool faceInRange(const KmdView& kmd, int meshNum, int face) {
+	Span<const uint8_t> faceIndices = kmd.faceIndices(meshNum);
+	Span<const uint8_t> normalFaceIndices = kmd.normalFaceIndices(meshNum);
+
+	for (int j = face * 4; j < face * 4 + 4; j++) {
+		if (faceIndices[j] >= kmd.vertices(meshNum).size()) return false;
+		if ((normalFaceIndices[j] & 0x7F) >= kmd.normals(meshNum).size()) return false;
+	}
+
+	return true;
+}
+
+template <typename T>
+static
+uint64_t hashSpan(Span<const T> span, uint64_t hash) {
+	return hashBytes(span.data(), span.size() * sizeof(T), hash);
+}
+
+//mesh number and parent are part of the key since decodeSkin bakes them into the bones
+uint64_t kmdMeshKey(const KmdView& kmd, int meshNum) {
+	const KmdMesh& mesh = kmd.meshes()[meshNum];
+	int32_t header[3] = { meshNum, mesh.parent, (int32_t)mesh.numFace };
+
+	uint64_t hash = hashBytes(header, sizeof(header));
+	hash = hashSpan(kmd.vertices(meshNum), hash);
+	hash = hashSpan(kmd.normals(meshNum), hash);
+	hash = hashSpan(kmd.faceIndices(meshNum), hash);
+	hash = hashSpan(kmd.normalFaceIndices(meshNum), hash);
+	hash = hashSpan(kmd.uvs(meshNum), hash);
+	return hashSpan(kmd.materials(meshNum), hash);
+}
+
+static
+void decodeSkin(int16_t parent, const KmdMesh& mesh, int meshNum, KmdGeometry& geo) {
+	geo.weights.push_back(1.0f);
+	int boneIdx = parent == -1 ? meshNum : mesh.parent;
+	geo.bones.push_back(boneIdx);
+}
+
+static
+void appendBatch(uint16_t strcode, uint32_t numIndices, KmdGeometry& geo) {
+	if (!geo.batches.empty() && geo.batches.back().strcode == strcode) {
+		geo.batches.back().numIndices += numIndices;
+		return;
+	}
+
+	uint32_t firstIndex = geo.indices.size() - numIndices;
+	geo.batches.push_back({ strcode, firstIndex, numIndices });
+}
+
+//pure cpu work, touches nothing but kmd and geo so meshes can decode in parallel
+void decodeKmdMesh(const KmdView& kmd, int meshNum, KmdGeometry& geo, bool quantized) {
+	const KmdMesh& mesh = kmd.meshes()[meshNum];
+	Span<const KmdUV> uvs = kmd.uvs(meshNum);
+	Span<const uint8_t> faceIndices = kmd.faceIndices(meshNum);
+	Span<const KmdVert> vertices = kmd.vertices(meshNum);
+	Span<const KmdNVert> normals = kmd.normals(meshNum);
+	Span<const uint16_t> materials = kmd.materials(meshNum);
+	Span<const uint8_t> normalFaceIndices = kmd.normalFaceIndices(meshNum);
+
+	//gather per corner first so the float conversion runs in bulk, into this thread's scratch arena
+	Arena& scratch = scratchArena();
+	ArenaScope scope(scratch);
+	ArenaVector<KmdVert> gatheredVertices(scratch);
+	ArenaVector<KmdNVert> gatheredNormals(scratch);
+	ArenaVector<KmdUV> gatheredUVs(scratch);
+
+	gatheredVertices.reserve(mesh.numFace * 4);
+	gatheredNormals.reserve(mesh.numFace * 4);
+	gatheredUVs.reserve(mesh.numFace * 4);
+	geo.weights.reserve(mesh.numFace * 4);
+	geo.bones.reserve(mesh.numFace * 4);
+	geo.indices.reserve(mesh.numFace * 6);
+
+	for (uint32_t i = 0; i < mesh.numFace; i++) {
+		if (!faceInRange(kmd, meshNum, i)) continue;
+
+		uint32_t base = geo.weights.size();
+		int x = i * 4;
+
+		for (int j = x; j < x + 4; j++) {
+			uint8_t fa = faceIndices[j];
+			uint8_t na = normalFaceIndices[j] & 0x7F;
+
+			gatheredUVs.push_back(uvs[j]);
+			gatheredVertices.push_back(vertices[fa]);
+			gatheredNormals.push_back(normals[na]);
+			decodeSkin(vertices[fa].w, mesh, meshNum, geo);
+		}
+
+		uint32_t numIndices = 3;
+		geo.indices.insert(geo.indices.end(), { base, base + 2, base + 1 });
+
+		//a triangle repeats its last index
+		if (faceIndices[x + 2] != faceIndices[x + 3]) {
+			geo.indices.insert(geo.indices.end(), { base, base + 3, base + 2 });
+			numIndices += 3;
+		}
+
+		appendBatch(materials[i], numIndices, geo);
+	}
+
+	size_t numVertex = gatheredVertices.size();
+	geo.quantized = quantized;
+
+	if (quantized) {
+		geo.shortPositions.resize(numVertex * 3);
+		geo.halfNormals.resize(numVertex * 3);
+		geo.byteUVs.assign(gatheredUVs.begin(), gatheredUVs.end());
+
+		packVertices(gatheredVertices.data(), numVertex, geo.shortPositions.data());
+		packNormalsHalf(gatheredNormals.data(), numVertex, geo.halfNormals.data());
+		return;
+	}
+
+	geo.positions.resize(numVertex * 3);
+	geo.normals.resize(numVertex * 3);
+	geo.uvs.resize(numVertex * 2);
+
+	convertVertices(gatheredVertices.data(), numVertex, 1.0f, geo.positions.data());
+	convertNormals(gatheredNormals.data(), numVertex, 1 / 4096.0f, geo.normals.data());
+	convertUVs(gatheredUVs.data(), numVertex, 1 / 256.0f, geo.uvs.data());
+}
+
+std::vector<KmdGeometry> decodeKmd(const KmdView& kmd, ThreadPool* pool, bool quantized) {
+	std::vector<KmdGeometry> geometry(kmd.numMesh());
+	auto decode = [&](int i) { decodeKmdMesh(kmd, i, geometry[i], quantized); };
+
+	if (pool) {
+		pool->parallelFor(geometry.size(), decode);
+	} else {
+		for (int i = 0; i < geometry.size(); i++) decode(i);
+	}
+
+	for (const KmdGeometry& geo : geometry) countKmdGeometry(geo);
+	return geometry;
+}
+
+template <typename T>
+static
+void countStream(const std::vector<T>& stream) {
+	if (stream.capacity()) memCount(MEM_GEOMETRY, stream.capacity() * sizeof(T));
+}
+
+void countKmdGeometry(const KmdGeometry& geo) {
+	countStream(geo.positions);
+	countStream(geo.normals);
+	countStream(geo.uvs);
+	countStream(geo.shortPositions);
+	countStream(geo.halfNormals);
+	countStream(geo.byteUVs);
+	countStream(geo.weights);
+	countStream(geo.bones);
+	countStream(geo.indices);
+	countStream(geo.batches);
+	countStream(geo.batchPages);
+	for (const KmdGeometry& lod : geo.lods) countKmdGeometry(lod);
+}
+
+struct WeldKey {
+	uint8_t bytes[36];
+
+	bool operator==(const WeldKey& other) const {
+		return !memcmp(bytes, other.bytes, sizeof(bytes));
+	}
+};
+
+struct WeldKeyHash {
+	size_t operator()(const WeldKey& key) const {
+		return hashBytes(key.bytes, sizeof(key.bytes));
+	}
+};
+
+template <typename T>
+static
+void moveVertex(std::vector<T>& stream, int width, size_t from, size_t to) {
+	for (int c = 0; c < width; c++) stream[to * width + c] = stream[from * width + c];
+}
+
+//corners sharing position, normal, uv and bone collapse into one vertex, compacted in place
+void weldKmdGeometry(KmdGeometry& geo) {
+	size_t numVertex = geo.weights.size();
+	std::vector<uint32_t> remap(numVertex);
+	std::unordered_map<WeldKey, uint32_t, WeldKeyHash> unique;
+	uint32_t numUnique = 0;
+
+	unique.reserve(numVertex);
+
+	for (size_t i = 0; i < numVertex; i++) {
+		WeldKey key = {};
+
+		if (geo.quantized) {
+			memcpy(&key.bytes[0], &geo.shortPositions[i * 3], 6);
+			memcpy(&key.bytes[6], &geo.halfNormals[i * 3], 6);
+			memcpy(&key.bytes[12], &geo.byteUVs[i], 2);
+		} else {
+			memcpy(&key.bytes[0], &geo.positions[i * 3], 12);
+			memcpy(&key.bytes[12], &geo.normals[i * 3], 12);
+			memcpy(&key.bytes[24], &geo.uvs[i * 2], 8);
+		}
+		key.bytes[32] = geo.bones[i];
+
+		auto it = unique.emplace(key, numUnique);
+		remap[i] = it.first->second;
+		if (!it.second) continue;
+
+		if (geo.quantized) {
+			moveVertex(geo.shortPositions, 3, i, numUnique);
+			moveVertex(geo.halfNormals, 3, i, numUnique);
+			moveVertex(geo.byteUVs, 1, i, numUnique);
+		} else {
+			moveVertex(geo.positions, 3, i, numUnique);
+			moveVertex(geo.normals, 3, i, numUnique);
+			moveVertex(geo.uvs, 2, i, numUnique);
+		}
+
+		moveVertex(geo.weights, 1, i, numUnique);
+		moveVertex(geo.bones, 1, i, numUnique);
+		numUnique++;
+	}
+
+	for (uint32_t& index : geo.indices) index = remap[index];
+
+	if (geo.quantized) {
+		geo.shortPositions.resize(numUnique * 3);
+		geo.halfNormals.resize(numUnique * 3);
+		geo.byteUVs.resize(numUnique);
+	} else {
+		geo.positions.resize(numUnique * 3);
+		geo.normals.resize(numUnique * 3);
+		geo.uvs.resize(numUnique * 2);
+	}
+
+	geo.weights.resize(numUnique);
+	geo.bones.resize(numUnique);
+}
\ No newline at end of file
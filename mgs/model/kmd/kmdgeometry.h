@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include "kmd.h"
+#include "../../common/threadpool.h"
+
+//run of consecutive faces sharing one material
+struct KmdBatch {
+	uint16_t strcode;
+	uint32_t firstIndex;
+	uint32_t numIndices;
+};
+
+//one mesh expanded to 4 vertices per face, ready to hand to a renderer
+struct KmdGeometry {
+	bool quantized = false;
+
+	std::vector<float>    positions;
+	std::vector<float>    normals;
+	std::vector<float>    uvs;
+
+	//filled instead of the float streams when quantized, uvs stay in 1/256 units
+	std::vector<int16_t>  shortPositions;
+	std::vector<uint16_t> halfNormals;
+	std::vector<KmdUV>    byteUVs;
+
+	std::vector<float>    weights;
+	std::vector<uint8_t>  bones;
+	std::vector<uint32_t> indices;
+	std::vector<KmdBatch> batches;
+
+	//set by applyAtlas, atlas page per batch or -1 for the batch's own material
+	std::vector<int>      batchPages;
+
+	//set by buildKmdLods, coarser copies of this mesh, each with about half the triangles of the last
+	std::vector<KmdGeometry> lods;
+};
+
+bool faceInRange(const KmdView& kmd, int meshNum, int face);
+//covers everything decodeKmdMesh reads, meshes with equal keys decode to the same geometry
+uint64_t kmdMeshKey(const KmdView& kmd, int meshNum);
+void decodeKmdMesh(const KmdView& kmd, int meshNum, KmdGeometry& geo, bool quantized = false);
+std::vector<KmdGeometry> decodeKmd(const KmdView& kmd, ThreadPool* pool, bool quantized = false);
+//adds geo's streams to the calling thread's memory stats, workers don't have any installed
+void countKmdGeometry(const KmdGeometry& geo);
+void weldKmdGeometry(KmdGeometry& geo);
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "kmdoptimize.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+static const int CACHE_SIZE = 32;
+
+//recently used vertices score high, the last triangle's a little less so nothing gets drawn twice in a row.
+//vertices with few triangles left get a boost so they're finished off rather than stranded
+static
+float vertexScore(int cachePos, uint32_t numLive) {
+	if (!numLive) return -1.0f;
+
+	float score = 0.0f;
+	if (cachePos >= 3) {
+		score = powf(1.0f - (cachePos - 3) / (float)(CACHE_SIZE - 3), 1.5f);
+	} else if (cachePos >= 0) {
+		score = 0.75f;
+	}
+
+	return score + 2.0f / sqrtf((float)numLive);
+}
+
+struct CacheState {
+	std::vector<uint32_t> numLive;   //triangles not yet emitted per vertex
+	std::vector<uint32_t> liveStart; //each vertex's run in liveTris
+	std::vector<uint32_t> liveTris;
+	std::vector<int>      cachePos;
+	std::vector<float>    score;
+};
+
+static
+void optimizeBatch(uint32_t* indices, uint32_t numTris, CacheState& state) {
+	std::vector<uint32_t> source(indices, indices + numTris * 3);
+	std::vector<bool> emitted(numTris, false);
+	std::vector<uint32_t> cache, nextCache;
+
+	//the batch's vertices, runs are laid out in order of first use so only those get touched
+	std::vector<uint32_t> used;
+	for (uint32_t index : source) {
+		if (!state.numLive[index]++) used.push_back(index);
+	}
+
+	uint32_t offset = 0;
+	for (uint32_t v : used) {
+		state.liveStart[v] = offset;
+		offset += state.numLive[v];
+		state.numLive[v] = 0;
+	}
+
+	state.liveTris.resize(offset);
+	for (uint32_t t = 0; t < numTris; t++) {
+		for (int c = 0; c < 3; c++) {
+			uint32_t v = source[t * 3 + c];
+			state.liveTris[state.liveStart[v] + state.numLive[v]++] = t;
+		}
+	}
+
+	for (uint32_t v : used) state.score[v] = vertexScore(-1, state.numLive[v]);
+
+	auto triScore = [&](uint32_t t) {
+		return state.score[source[t * 3]] + state.score[source[t * 3 + 1]] + state.score[source[t * 3 + 2]];
+	};
+
+	int best = -1;
+	float bestScore = -1.0f;
+	for (uint32_t t = 0; t < numTris; t++) {
+		float score = triScore(t);
+		if (score > bestScore) {
+			best = t;
+			bestScore = score;
+		}
+	}
+
+	uint32_t cursor = 0;
+
+	for (uint32_t n = 0; n < numTris; n++) {
+		//nothing in the cache has triangles left, carry on in file order
+		if (best < 0) {
+			while (emitted[cursor]) cursor++;
+			best = cursor;
+		}
+
+		const uint32_t* tri = &source[best * 3];
+		memcpy(&indices[n * 3], tri, 12);
+		emitted[best] = true;
+
+		for (int c = 0; c < 3; c++) {
+			uint32_t v = tri[c];
+			uint32_t* live = &state.liveTris[state.liveStart[v]];
+			for (uint32_t i = 0; i < state.numLive[v]; i++) {
+				if (live[i] != (uint32_t)best) continue;
+				live[i] = live[--state.numLive[v]];
+				break;
+			}
+		}
+
+		//the triangle's vertices move to the front, the rest shift back and fall off the end
+		nextCache.clear();
+		for (int c = 0; c < 3; c++) {
+			if (std::find(nextCache.begin(), nextCache.end(), tri[c]) == nextCache.end()) nextCache.push_back(tri[c]);
+		}
+
+		for (uint32_t v : cache) {
+			if (v != tri[0] && v != tri[1] && v != tri[2]) nextCache.push_back(v);
+		}
+
+		for (int i = 0; i < nextCache.size(); i++) {
+			uint32_t v = nextCache[i];
+			state.cachePos[v] = i < CACHE_SIZE ? i : -1;
+			state.score[v] = vertexScore(state.cachePos[v], state.numLive[v]);
+		}
+
+		if (nextCache.size() > CACHE_SIZE) nextCache.resize(CACHE_SIZE);
+		cache.swap(nextCache);
+
+		best = -1;
+		bestScore = -1.0f;
+		for (uint32_t v : cache) {
+			const uint32_t* live = &state.liveTris[state.liveStart[v]];
+			for (uint32_t i = 0; i < state.numLive[v]; i++) {
+				float score = triScore(live[i]);
+				if (score > bestScore) {
+					best = live[i];
+					bestScore = score;
+				}
+			}
+		}
+	}
+
+	for (uint32_t v : cache) state.cachePos[v] = -1;
+}
+
+void optimizeVertexCache(KmdGeometry& geo) {
+	size_t numVertex = geo.weights.size();
+	if (!numVertex) return;
+
+	CacheState state;
+	state.numLive.assign(numVertex, 0);
+	state.liveStart.assign(numVertex, 0);
+	state.cachePos.assign(numVertex, -1);
+	state.score.assign(numVertex, 0.0f);
+
+	for (const KmdBatch& batch : geo.batches) {
+		optimizeBatch(&geo.indices[batch.firstIndex], batch.numIndices / 3, state);
+	}
+}
+
+template <typename T>
+static
+void reorderStream(std::vector<T>& stream, const std::vector<uint32_t>& order) {
+	if (stream.empty()) return;
+
+	size_t width = stream.size() / order.size();
+	std::vector<T> reordered(stream.size());
+
+	for (size_t i = 0; i < order.size(); i++) {
+		for (size_t c = 0; c < width; c++) reordered[i * width + c] = stream[order[i] * width + c];
+	}
+
+	stream.swap(reordered);
+}
+
+void optimizeVertexFetch(KmdGeometry& geo) {
+	size_t numVertex = geo.weights.size();
+	if (!numVertex) return;
+
+	std::vector<uint32_t> remap(numVertex, UINT32_MAX);
+	std::vector<uint32_t> order;
+	order.reserve(numVertex);
+
+	for (uint32_t& index : geo.indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = order.size();
+			order.push_back(index);
+		}
+		index = remap[index];
+	}
+
+	//nothing refers to these, they keep their relative order at the end
+	for (uint32_t v = 0; v < numVertex; v++) {
+		if (remap[v] == UINT32_MAX) order.push_back(v);
+	}
+
+	reorderStream(geo.positions, order);
+	reorderStream(geo.normals, order);
+	reorderStream(geo.uvs, order);
+	reorderStream(geo.shortPositions, order);
+	reorderStream(geo.halfNormals, order);
+	reorderStream(geo.byteUVs, order);
+	reorderStream(geo.weights, order);
+	reorderStream(geo.bones, order);
+}
+
+void optimizeKmdGeometry(KmdGeometry& geo) {
+	optimizeVertexCache(geo);
+	optimizeVertexFetch(geo);
+}
\ No newline at end of file
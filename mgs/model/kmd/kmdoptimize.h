@@ -0,0 +1,10 @@
+#pragma once
+#include "kmdgeometry.h"
+
+//reorders each batch's triangles for post-transform cache reuse (Forsyth's linear-speed optimiser).
+//batches keep their ranges and triangles their winding, only makes a difference on welded geometry
+void optimizeVertexCache(KmdGeometry& geo);
+//renumbers vertices in the order the indices first use them, so fetches walk the streams forwards
+void optimizeVertexFetch(KmdGeometry& geo);
+//both of the above, cache order first since fetch order follows it
+void optimizeKmdGeometry(KmdGeometry& geo);
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "kmdsimplify.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include "../../common/hash.h"
+
+//cosine of the furthest a surviving triangle may turn in one collapse, about 70 degrees
+static const double MAX_TURN_COS = 0.35;
+//error allowed for the first lod as a fraction of the mesh's size, doubling with each level after
+static const float LOD_MAX_ERROR = 0.01f;
+
+//plane equations summed over a vertex's triangles, weighted by area. stored as the upper triangle of the 4x4
+struct Quadric {
+	double a[10] = {};
+	double weight = 0.0;
+
+	void addPlane(const double* n, double d, double weight) {
+		double p[4] = { n[0], n[1], n[2], d };
+		int k = 0;
+		for (int i = 0; i < 4; i++) {
+			for (int j = i; j < 4; j++) a[k++] += p[i] * p[j] * weight;
+		}
+		this->weight += weight;
+	}
+
+	void add(const Quadric& other) {
+		for (int i = 0; i < 10; i++) a[i] += other.a[i];
+		weight += other.weight;
+	}
+
+	double error(const float* v) const {
+		double p[4] = { v[0], v[1], v[2], 1.0 };
+		double sum = 0.0;
+		int k = 0;
+		for (int i = 0; i < 4; i++) {
+			for (int j = i; j < 4; j++) sum += a[k++] * p[i] * p[j] * (i == j ? 1.0 : 2.0);
+		}
+		//mean squared distance to the planes rather than a sum, so it can be compared with a length
+		return weight > 0.0 ? sum / weight : 0.0;
+	}
+};
+
+struct Collapse {
+	uint32_t from;
+	uint32_t to;
+	double cost;
+};
+
+static
+void triangleNormal(const float* p0, const float* p1, const float* p2, double* n) {
+	double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+	return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+}
+
+template <typename T>
+static
+void gatherStream(const std::vector<T>& stream, const std::vector<uint32_t>& order, size_t numVertex, std::vector<T>& out) {
+	out.clear();
+	if (stream.empty()) return;
+
+	size_t width = stream.size() / numVertex;
+	out.reserve(order.size() * width);
+	for (uint32_t v : order) out.insert(out.end(), stream.begin() + v * width, stream.begin() + (v + 1) * width);
+}
+
+//seams are positions more than one welded vertex sits on, the rest are found from the triangles
+static
+void lockVertices(const std::vector<float>& pos, const std::vector<uint32_t>& tris, const std::vector<int>& triBatch, std::vector<bool>& locked) {
+	size_t numVertex = pos.size() / 3;
+
+	std::unordered_map<uint64_t, int> positions;
+	for (size_t v = 0; v < numVertex; v++) positions[hashBytes(&pos[v * 3], 12)]++;
+	for (size_t v = 0; v < numVertex; v++) {
+		if (positions[hashBytes(&pos[v * 3], 12)] > 1) locked[v] = true;
+	}
+
+	std::vector<int> vertexBatch(numVertex, -1);
+	std::unordered_map<uint64_t, int> edgeUses;
+
+	for (size_t t = 0; t < tris.size() / 3; t++) {
+		for (int c = 0; c < 3; c++) {
+			uint32_t v = tris[t * 3 + c];
+			if (vertexBatch[v] != -1 && vertexBatch[v] != triBatch[t]) locked[v] = true;
+			vertexBatch[v] = triBatch[t];
+			edgeUses[edgeKey(v, tris[t * 3 + (c + 1) % 3])]++;
+		}
+	}
+
+	//open edges and edges shared by more than two triangles
+	for (const std::pair<const uint64_t, int>& edge : edgeUses) {
+		if (edge.second == 2) continue;
+		locked[edge.first >> 32] = true;
+		locked[edge.first & 0xFFFFFFFF] = true;
+	}
+}
+
+//one round of non-overlapping collapses, cheapest first. returns the number of triangles removed
+static
+size_t collapsePass(const std::vector<float>& pos, const std::vector<uint8_t>& bones, const std::vector<bool>& locked, std::vector<Quadric>& quadrics,
+	std::vector<uint32_t>& tris, std::vector<bool>& dead, size_t maxRemove, double maxCost) {
+	size_t numVertex = pos.size() / 3;
+	size_t numTris = tris.size() / 3;
+
+	std::vector<uint32_t> triStart(numVertex + 1, 0);
+	for (size_t t = 0; t < numTris; t++) {
+		if (dead[t]) continue;
+		for (int c = 0; c < 3; c++) triStart[tris[t * 3 + c] + 1]++;
+	}
+	for (size_t v = 0; v < numVertex; v++) triStart[v + 1] += triStart[v];
+
+	std::vector<uint32_t> vertexTris(triStart[numVertex]);
+	std::vector<uint32_t> fill(triStart.begin(), triStart.end() - 1);
+	for (size_t t = 0; t < numTris; t++) {
+		if (dead[t]) continue;
+		for (int c = 0; c < 3; c++) vertexTris[fill[tris[t * 3 + c]]++] = t;
+	}
+
+	std::vector<Collapse> collapses;
+	for (size_t t = 0; t < numTris; t++) {
+		if (dead[t]) continue;
+
+		for (int c = 0; c < 3; c++) {
+			uint32_t a = tris[t * 3 + c];
+			uint32_t b = tris[t * 3 + (c + 1) % 3];
+			if (bones[a] != bones[b]) continue;
+
+			Quadric q = quadrics[a];
+			q.add(quadrics[b]);
+
+			double toB = q.error(&pos[b * 3]);
+			double toA = q.error(&pos[a * 3]);
+			if (!locked[a] && toB <= maxCost) collapses.push_back({ a, b, toB });
+			if (!locked[b] && toA <= maxCost) collapses.push_back({ b, a, toA });
+		}
+	}
+
+	std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+	std::vector<bool> touched(numVertex, false);
+	size_t removed = 0;
+
+	for (const Collapse& collapse : collapses) {
+		if (removed >= maxRemove) break;
+		if (touched[collapse.from] || touched[collapse.to]) continue;
+
+		const uint32_t* around = &vertexTris[triStart[collapse.from]];
+		size_t numAround = triStart[collapse.from + 1] - triStart[collapse.from];
+
+		//triangles that keep their area mustn't turn over, collapse to a line or swing round into fins
+		bool flips = false;
+		for (size_t i = 0; i < numAround && !flips; i++) {
+			const uint32_t* tri = &tris[around[i] * 3];
+			if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) continue;
+
+			const float* before[3];
+			const float* after[3];
+			for (int c = 0; c < 3; c++) {
+				before[c] = &pos[tri[c] * 3];
+				after[c] = tri[c] == collapse.from ? &pos[collapse.to * 3] : before[c];
+			}
+
+			double n0[3], n1[3];
+			triangleNormal(before[0], before[1], before[2], n0);
+			triangleNormal(after[0], after[1], after[2], n1);
+			double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+			double lengths = sqrt((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+			flips = dot <= lengths * MAX_TURN_COS;
+		}
+
+		if (flips) continue;
+
+		//the one ring is claimed as well, later collapses this pass would test against stale triangles
+		for (size_t i = 0; i < numAround; i++) {
+			uint32_t* tri = &tris[around[i] * 3];
+			for (int c = 0; c < 3; c++) {
+				touched[tri[c]] = true;
+				if (tri[c] == collapse.from) tri[c] = collapse.to;
+			}
+
+			if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+				dead[around[i]] = true;
+				removed++;
+			}
+		}
+
+		quadrics[collapse.to].add(quadrics[collapse.from]);
+	}
+
+	return removed;
+}
+
+void simplifyKmdGeometry(const KmdGeometry& geo, float targetRatio, float maxError, KmdGeometry& out) {
+	size_t numVertex = geo.weights.size();
+	size_t numTris = geo.indices.size() / 3;
+
+	std::vector<float> pos(numVertex * 3);
+	for (size_t i = 0; i < numVertex * 3; i++) pos[i] = geo.quantized ? geo.shortPositions[i] : geo.positions[i];
+
+	float lo[3] = { 1e30f, 1e30f, 1e30f };
+	float hi[3] = { -1e30f, -1e30f, -1e30f };
+	for (size_t i = 0; i < numVertex * 3; i++) {
+		lo[i % 3] = std::min(lo[i % 3], pos[i]);
+		hi[i % 3] = std::max(hi[i % 3], pos[i]);
+	}
+
+	double extent = std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 0.0f });
+	double maxCost = extent * maxError * extent * maxError;
+
+	std::vector<uint32_t> tris(geo.indices.begin(), geo.indices.begin() + numTris * 3);
+	std::vector<int> triBatch(numTris);
+	for (int b = 0; b < geo.batches.size(); b++) {
+		const KmdBatch& batch = geo.batches[b];
+		for (uint32_t t = batch.firstIndex / 3; t < (batch.firstIndex + batch.numIndices) / 3; t++) triBatch[t] = b;
+	}
+
+	std::vector<bool> locked(numVertex, false);
+	lockVertices(pos, tris, triBatch, locked);
+
+	std::vector<Quadric> quadrics(numVertex);
+	for (size_t t = 0; t < numTris; t++) {
+		const uint32_t* tri = &tris[t * 3];
+		double n[3];
+		triangleNormal(&pos[tri[0] * 3], &pos[tri[1] * 3], &pos[tri[2] * 3], n);
+
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length <= 0.0) continue;
+
+		for (int c = 0; c < 3; c++) n[c] /= length;
+		double d = -(n[0] * pos[tri[0] * 3] + n[1] * pos[tri[0] * 3 + 1] + n[2] * pos[tri[0] * 3 + 2]);
+		for (int c = 0; c < 3; c++) quadrics[tri[c]].addPlane(n, d, length * 0.5);
+	}
+
+	std::vector<bool> dead(numTris, false);
+	size_t target = (size_t)(numTris * targetRatio);
+	size_t alive = numTris;
+
+	while (alive > target) {
+		size_t removed = collapsePass(pos, geo.bones, locked, quadrics, tris, dead, alive - target, maxCost);
+		if (!removed) break;
+		alive -= removed;
+	}
+
+	//surviving triangles keep their batch and order, vertices are renumbered by first use
+	std::vector<uint32_t> remap(numVertex, UINT32_MAX);
+	std::vector<uint32_t> order;
+
+	out = KmdGeometry();
+	out.quantized = geo.quantized;
+
+	for (int b = 0; b < geo.batches.size(); b++) {
+		const KmdBatch& batch = geo.batches[b];
+		uint32_t firstIndex = out.indices.size();
+
+		for (uint32_t t = batch.firstIndex / 3; t < (batch.firstIndex + batch.numIndices) / 3; t++) {
+			if (dead[t]) continue;
+
+			for (int c = 0; c < 3; c++) {
+				uint32_t v = tris[t * 3 + c];
+				if (remap[v] == UINT32_MAX) {
+					remap[v] = order.size();
+					order.push_back(v);
+				}
+				out.indices.push_back(remap[v]);
+			}
+		}
+
+		if (out.indices.size() == firstIndex) continue;
+		out.batches.push_back({ batch.strcode, firstIndex, (uint32_t)out.indices.size() - firstIndex });
+		if (!geo.batchPages.empty()) out.batchPages.push_back(geo.batchPages[b]);
+	}
+
+	gatherStream(geo.positions, order, numVertex, out.positions);
+	gatherStream(geo.normals, order, numVertex, out.normals);
+	gatherStream(geo.uvs, order, numVertex, out.uvs);
+	gatherStream(geo.shortPositions, order, numVertex, out.shortPositions);
+	gatherStream(geo.halfNormals, order, numVertex, out.halfNormals);
+	gatherStream(geo.byteUVs, order, numVertex, out.byteUVs);
+	gatherStream(geo.weights, order, numVertex, out.weights);
+	gatherStream(geo.bones, order, numVertex, out.bones);
+}
+
+void buildKmdLods(KmdGeometry& geo, int numLevels) {
+	geo.lods.clear();
+	geo.lods.reserve(numLevels);
+	const KmdGeometry* source = &geo;
+
+	for (int i = 0; i < numLevels; i++) {
+		KmdGeometry lod;
+		simplifyKmdGeometry(*source, 0.5f, LOD_MAX_ERROR * (1 << i), lod);
+		if (lod.indices.size() > source->indices.size() * 9 / 10) break;
+
+		geo.lods.push_back(std::move(lod));
+		source = &geo.lods.back();
+	}
+}
\ No newline at end of file
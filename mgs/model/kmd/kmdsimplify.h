@@ -0,0 +1,11 @@
+#pragma once
+#include "kmdgeometry.h"
+
+//quadric error edge collapses on welded geometry until about targetRatio of the triangles are left, or no
+//collapse stays within maxError (a fraction of the mesh's largest extent). vertices on material borders,
+//uv or normal seams and open edges stay where they are, and a vertex only collapses into one on the same
+//bone so rigid parts don't bleed into each other
+void simplifyKmdGeometry(const KmdGeometry& geo, float targetRatio, float maxError, KmdGeometry& out);
+//fills geo.lods with up to numLevels copies, each about half the triangles of the one before.
+//stops early once a level hardly shrinks, which happens when little more than seams is left
+void buildKmdLods(KmdGeometry& geo, int numLevels);
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "kmdskeleton.h"
+
+int KmdSkeleton::numBones() const {
+	return parents.size();
+}
+
+void KmdSkeleton::worldTranslation(int bone, float out[3]) const {
+	out[0] = worldX[bone];
+	out[1] = worldY[bone];
+	out[2] = worldZ[bone];
+}
+
+void KmdSkeleton::inverseBindMatrices(std::vector<float>& matrices) const {
+	matrices.assign(parents.size() * 16, 0.0f);
+
+	for (size_t i = 0; i < parents.size(); i++) {
+		float* m = &matrices[i * 16];
+		m[0] = m[5] = m[10] = m[15] = 1.0f;
+		m[12] = -worldX[i];
+		m[13] = -worldY[i];
+		m[14] = -worldZ[i];
+	}
+}
+
+//breadth first from the roots. validateKmd only rules out a mesh being its own parent, so bones
+//left over hang off a longer loop. their parents are followed until one repeats, which is on the loop,
+//and the loop is cut there so every other bone keeps its parent
+void buildKmdSkeleton(const KmdView& kmd, KmdSkeleton& skeleton) {
+	Span<const KmdMesh> meshes = kmd.meshes();
+	int numBones = meshes.size();
+
+	skeleton.parents.resize(numBones);
+	skeleton.localX.resize(numBones);
+	skeleton.localY.resize(numBones);
+	skeleton.localZ.resize(numBones);
+
+	std::vector<int> childStart(numBones + 1, 0);
+
+	for (int i = 0; i < numBones; i++) {
+		skeleton.parents[i] = meshes[i].parent;
+		skeleton.localX[i] = meshes[i].pos.x;
+		skeleton.localY[i] = meshes[i].pos.y;
+		skeleton.localZ[i] = meshes[i].pos.z;
+		if (meshes[i].parent > -1) childStart[meshes[i].parent + 1]++;
+	}
+
+	for (int i = 0; i < numBones; i++) childStart[i + 1] += childStart[i];
+
+	std::vector<int> children(childStart[numBones]);
+	std::vector<int> cursor(childStart.begin(), childStart.end() - 1);
+	for (int i = 0; i < numBones; i++) {
+		if (meshes[i].parent > -1) children[cursor[meshes[i].parent]++] = i;
+	}
+
+	std::vector<bool> placed(numBones, false);
+	skeleton.order.clear();
+	skeleton.order.reserve(numBones);
+	size_t next = 0;
+
+	auto place = [&](int bone) {
+		placed[bone] = true;
+		skeleton.order.push_back(bone);
+
+		for (; next < skeleton.order.size(); next++) {
+			int parent = skeleton.order[next];
+			for (int c = childStart[parent]; c < childStart[parent + 1]; c++) {
+				if (placed[children[c]]) continue;
+				placed[children[c]] = true;
+				skeleton.order.push_back(children[c]);
+			}
+		}
+	};
+
+	for (int i = 0; i < numBones; i++) {
+		if (skeleton.parents[i] < 0) place(i);
+	}
+
+	std::vector<int> visited(numBones, -1);
+
+	for (int i = 0; i < numBones; i++) {
+		if (placed[i]) continue;
+
+		int bone = i;
+		for (; visited[bone] != i; bone = skeleton.parents[bone]) visited[bone] = i;
+
+		skeleton.parents[bone] = -1;
+		place(bone);
+	}
+
+	skeleton.worldX.resize(numBones);
+	skeleton.worldY.resize(numBones);
+	skeleton.worldZ.resize(numBones);
+
+	for (int bone : skeleton.order) {
+		int parent = skeleton.parents[bone];
+		skeleton.worldX[bone] = skeleton.localX[bone] + (parent > -1 ? skeleton.worldX[parent] : 0.0f);
+		skeleton.worldY[bone] = skeleton.localY[bone] + (parent > -1 ? skeleton.worldY[parent] : 0.0f);
+		skeleton.worldZ[bone] = skeleton.localZ[bone] + (parent > -1 ? skeleton.worldZ[parent] : 0.0f);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include "kmd.h"
+
+//a kmd's bones, one per mesh, sorted once so every parent comes before its children.
+//translations are kept as one array per axis and worked out in a single pass over that order.
+//the bind pose has no rotation, so a bone's inverse bind is its world translation negated
+struct KmdSkeleton {
+	std::vector<int> parents; //-1 for roots, and for the bone a parent loop was cut at
+	std::vector<int> order;
+
+	std::vector<float> localX, localY, localZ;
+	std::vector<float> worldX, worldY, worldZ;
+
+	int numBones() const;
+	void worldTranslation(int bone, float out[3]) const;
+	//column major 4x4s as gltf skins store them
+	void inverseBindMatrices(std::vector<float>& matrices) const;
+};
+
+void buildKmdSkeleton(const KmdView& kmd, KmdSkeleton& skeleton);
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "kmdtopology.h"
+#include <unordered_map>
+
+void kmdBatchPolygons(const KmdGeometry& geo, const KmdBatch& batch, std::vector<KmdPolygon>& polygons) {
+	const uint32_t* tris = &geo.indices[batch.firstIndex];
+	uint32_t numTris = batch.numIndices / 3;
+
+	for (uint32_t t = 0; t < numTris; t++) {
+		const uint32_t* tri = &tris[t * 3];
+
+		if (t + 1 < numTris) {
+			const uint32_t* next = &tris[t * 3 + 3];
+			uint32_t d = next[1];
+
+			if (next[0] == tri[0] && next[2] == tri[1] && d != tri[0] && d != tri[1] && d != tri[2]) {
+				polygons.push_back({ { tri[0], d, tri[1], tri[2] }, 4 });
+				t++;
+				continue;
+			}
+		}
+
+		polygons.push_back({ { tri[0], tri[1], tri[2], tri[2] }, 3 });
+	}
+}
+
+static
+uint64_t edgeKey(uint32_t from, uint32_t to) {
+	return (uint64_t)from << 32 | to;
+}
+
+//greedy, each run starts from the first unused triangle and follows whichever neighbour continues it
+bool stripKmdBatch(const KmdGeometry& geo, const KmdBatch& batch, std::vector<uint32_t>& strip) {
+	const uint32_t* tris = &geo.indices[batch.firstIndex];
+	uint32_t numTris = batch.numIndices / 3;
+
+	std::unordered_multimap<uint64_t, uint32_t> edges;
+	edges.reserve(numTris * 3);
+	for (uint32_t t = 0; t < numTris; t++) {
+		for (int c = 0; c < 3; c++) edges.emplace(edgeKey(tris[t * 3 + c], tris[t * 3 + (c + 1) % 3]), t);
+	}
+
+	std::vector<bool> used(numTris, false);
+
+	//the unused triangle with the directed edge from->to, and its third corner
+	auto findNext = [&](uint32_t from, uint32_t to, uint32_t& corner) {
+		auto range = edges.equal_range(edgeKey(from, to));
+		for (auto it = range.first; it != range.second; ++it) {
+			uint32_t t = it->second;
+			if (used[t]) continue;
+
+			for (int c = 0; c < 3; c++) {
+				if (tris[t * 3 + c] == from) corner = tris[t * 3 + (c + 2) % 3];
+			}
+			return (int)t;
+		}
+		return -1;
+	};
+
+	strip.clear();
+	strip.reserve(numTris + 2);
+
+	for (uint32_t start = 0; start < numTris; start++) {
+		if (used[start]) continue;
+		used[start] = true;
+
+		//lead with the rotation whose last edge has a neighbour, so the run gets past its first triangle
+		const uint32_t* tri = &tris[start * 3];
+		int rotation = 0;
+		for (int r = 0; r < 3; r++) {
+			uint32_t corner;
+			if (findNext(tri[(r + 2) % 3], tri[(r + 1) % 3], corner) >= 0) {
+				rotation = r;
+				break;
+			}
+		}
+
+		//runs have to start on an even position to keep their winding
+		if (!strip.empty()) {
+			uint32_t last = strip.back();
+			strip.push_back(last);
+			strip.push_back(tri[rotation]);
+			if (strip.size() % 2) strip.push_back(tri[rotation]);
+		}
+
+		for (int c = 0; c < 3; c++) strip.push_back(tri[(rotation + c) % 3]);
+
+		while (true) {
+			size_t n = strip.size();
+			bool even = (n - 3) % 2 == 0;
+			uint32_t a = strip[n - 2];
+			uint32_t b = strip[n - 1];
+			uint32_t corner;
+
+			int next = even ? findNext(b, a, corner) : findNext(a, b, corner);
+			if (next < 0) break;
+
+			used[next] = true;
+			strip.push_back(corner);
+		}
+	}
+
+	if (strip.size() < batch.numIndices) return true;
+
+	strip.clear();
+	return false;
+}
\ No newline at end of file
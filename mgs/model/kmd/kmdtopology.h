@@ -0,0 +1,15 @@
+#pragma once
+#include "kmdgeometry.h"
+
+//one face as the kmd authored it in geometry indices, triangles only use the first three corners
+struct KmdPolygon {
+	uint32_t v[4];
+	int numCorners;
+};
+
+//pairs the decoder's split quads back up, (a,b,c)(a,d,b) becomes (a,d,b,c). only looks at neighbouring
+//triangles, so it finds every quad as long as the batch keeps decode order (welding and fetch reordering do)
+void kmdBatchPolygons(const KmdGeometry& geo, const KmdBatch& batch, std::vector<KmdPolygon>& polygons);
+//the batch's triangles as one strip with the usual alternating winding, separate runs joined by
+//degenerate triangles. returns false, leaving strip empty, when that takes more indices than the list
+bool stripKmdBatch(const KmdGeometry& geo, const KmdBatch& batch, std::vector<uint32_t>& strip);
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "clip.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+static const uint32_t CLIP_MAGIC = 0x4C434D47; //GMCL
+static const uint16_t CLIP_VERSION = 1;
+static const float SQRT1_2 = 0.70710678f;
+
+static
+size_t alignUp(size_t offset) {
+	return (offset + 1) & ~(size_t)1;
+}
+
+//the largest component is dropped and rebuilt from the others, which then fit in +-1/sqrt(2).
+//15 bits each, the dropped index goes in the top bits of the first two
+static
+void packQuat(const float* q, uint16_t* out) {
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (fabsf(q[i]) > fabsf(q[largest])) largest = i;
+	}
+
+	float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+	int k = 0;
+
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) continue;
+		float c = std::min(std::max(q[i] * sign / SQRT1_2, -1.0f), 1.0f);
+		out[k++] = (uint16_t)lrintf((c * 0.5f + 0.5f) * 32767.0f);
+	}
+
+	out[0] |= (largest & 1) << 15;
+	out[1] |= (largest >> 1) << 15;
+}
+
+static
+void unpackQuat(const uint16_t* in, float* q) {
+	int largest = (in[0] >> 15) | (in[1] >> 15) << 1;
+	float sum = 0.0f;
+	int k = 0;
+
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) continue;
+		float c = ((in[k++] & 0x7FFF) / 32767.0f * 2.0f - 1.0f) * SQRT1_2;
+		q[i] = c;
+		sum += c * c;
+	}
+
+	q[largest] = sqrtf(std::max(0.0f, 1.0f - sum));
+}
+
+template <typename Key>
+static
+bool writeTimes(const std::vector<Key>& keys, std::vector<uint8_t>& clip) {
+	int last = 0;
+
+	for (const Key& key : keys) {
+		int delta = key.keyframe - last;
+		if (delta < 0 || delta > 0xFF) return false;
+
+		clip.push_back(delta);
+		last = key.keyframe;
+	}
+
+	clip.resize(alignUp(clip.size()));
+	return true;
+}
+
+static
+void writeValues(const uint16_t* values, size_t count, std::vector<uint8_t>& clip) {
+	size_t offset = clip.size();
+	clip.resize(offset + count * 2);
+	memcpy(&clip[offset], values, count * 2);
+}
+
+bool encodeClip(const OarMotion& motion, std::vector<uint8_t>& clip) {
+	std::vector<ClipTrack> tracks;
+	if (!motion.move.empty()) tracks.push_back({ CLIP_TRANSLATION, 0, (uint16_t)motion.move.size() });
+
+	for (int j = 0; j < motion.rotation.size(); j++) {
+		if (!motion.rotation[j].empty()) tracks.push_back({ CLIP_ROTATION, (uint8_t)j, (uint16_t)motion.rotation[j].size() });
+	}
+
+	if (motion.rotation.size() > 0x100 || motion.move.size() > 0xFFFF) return false;
+	for (const std::vector<OarRotKey>& rot : motion.rotation) {
+		if (rot.size() > 0xFFFF) return false;
+	}
+
+	clip.assign(sizeof(ClipHeader) + tracks.size() * sizeof(ClipTrack), 0);
+	std::vector<uint16_t> values;
+
+	for (ClipTrack& track : tracks) {
+		track.offset = clip.size();
+		values.clear();
+
+		if (track.type == CLIP_TRANSLATION) {
+			ClipRange range;
+			float lo[3] = { 1e30f, 1e30f, 1e30f };
+			float hi[3] = { -1e30f, -1e30f, -1e30f };
+
+			for (const OarMoveKey& key : motion.move) {
+				float v[3] = { key.x, key.y, key.z };
+				for (int c = 0; c < 3; c++) {
+					lo[c] = std::min(lo[c], v[c]);
+					hi[c] = std::max(hi[c], v[c]);
+				}
+			}
+
+			for (int c = 0; c < 3; c++) {
+				range.center[c] = (lo[c] + hi[c]) * 0.5f;
+				range.extent[c] = (hi[c] - lo[c]) * 0.5f;
+			}
+
+			for (const OarMoveKey& key : motion.move) {
+				float v[3] = { key.x, key.y, key.z };
+				for (int c = 0; c < 3; c++) {
+					float q = range.extent[c] > 0.0f ? (v[c] - range.center[c]) / range.extent[c] : 0.0f;
+					values.push_back((uint16_t)(int16_t)lrintf(q * 32767.0f));
+				}
+			}
+
+			clip.resize(track.offset + sizeof(ClipRange));
+			memcpy(&clip[track.offset], &range, sizeof(range));
+			if (!writeTimes(motion.move, clip)) return false;
+		} else {
+			const std::vector<OarRotKey>& rot = motion.rotation[track.joint];
+			if (!writeTimes(rot, clip)) return false;
+
+			for (const OarRotKey& key : rot) {
+				float q[4] = { key.x, key.y, key.z, key.w };
+				float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+				for (float& c : q) c /= length;
+
+				uint16_t packed[3];
+				packQuat(q, packed);
+				values.insert(values.end(), packed, packed + 3);
+			}
+		}
+
+		writeValues(values.data(), values.size(), clip);
+	}
+
+	ClipHeader header = { CLIP_MAGIC, CLIP_VERSION, (uint16_t)tracks.size(), (uint16_t)std::min(motion.numFrames, 0xFFFF), (uint16_t)g_oarFrameRate, (uint32_t)clip.size() };
+	memcpy(&clip[0], &header, sizeof(header));
+	if (!tracks.empty()) memcpy(&clip[sizeof(header)], tracks.data(), tracks.size() * sizeof(ClipTrack));
+	return true;
+}
+
+bool validateClip(const uint8_t* data, int size) {
+	if (!data || size < (int)sizeof(ClipHeader)) return false;
+
+	const ClipHeader* header = (const ClipHeader*)data;
+	if (header->magic != CLIP_MAGIC || header->version != CLIP_VERSION || header->size > (uint32_t)size || header->size < sizeof(ClipHeader)) return false;
+	if (header->numTracks > (header->size - sizeof(ClipHeader)) / sizeof(ClipTrack)) return false;
+
+	const ClipTrack* tracks = (const ClipTrack*)&data[sizeof(ClipHeader)];
+
+	for (int i = 0; i < header->numTracks; i++) {
+		const ClipTrack& track = tracks[i];
+		if (track.type > CLIP_TRANSLATION || !track.numKeys || track.offset % 2) return false;
+
+		uint64_t keys = track.offset + (track.type == CLIP_TRANSLATION ? sizeof(ClipRange) : 0);
+		uint64_t end = alignUp(keys + track.numKeys) + track.numKeys * 6ull;
+		if (track.offset < sizeof(ClipHeader) || end > header->size) return false;
+	}
+
+	return true;
+}
+
+ClipSampler::ClipSampler(const uint8_t* clip) {
+	this->clip = clip;
+	this->joints = 1;
+	this->cursors.resize(header()->numTracks);
+
+	for (int i = 0; i < header()->numTracks; i++) {
+		const ClipTrack& track = tracks()[i];
+		cursors[i] = { 0, clip[keyOffset(track)] };
+		if (track.type == CLIP_ROTATION) joints = std::max(joints, track.joint + 1);
+	}
+}
+
+size_t ClipSampler::keyOffset(const ClipTrack& track) const {
+	return track.offset + (track.type == CLIP_TRANSLATION ? sizeof(ClipRange) : 0);
+}
+
+const ClipHeader* ClipSampler::header() const {
+	return (const ClipHeader*)clip;
+}
+
+const ClipTrack* ClipSampler::tracks() const {
+	return (const ClipTrack*)&clip[sizeof(ClipHeader)];
+}
+
+int ClipSampler::numJoints() const {
+	return joints;
+}
+
+int ClipSampler::numFrames() const {
+	return header()->numFrames;
+}
+
+//tracks without keys leave their joint at identity, frames outside the keys hold the nearest one
+void ClipSampler::sample(float frame, ClipPose& pose) {
+	pose.rotations.assign(joints * 4, 0.0f);
+	for (int j = 0; j < joints; j++) pose.rotations[j * 4 + 3] = 1.0f;
+	pose.translation[0] = pose.translation[1] = pose.translation[2] = 0.0f;
+
+	for (int i = 0; i < header()->numTracks; i++) {
+		const ClipTrack& track = tracks()[i];
+		const uint8_t* deltas = &clip[keyOffset(track)];
+		const uint16_t* values = (const uint16_t*)&clip[alignUp(keyOffset(track) + track.numKeys)];
+		Cursor& cursor = cursors[i];
+
+		if (frame < cursor.frame) {
+			cursor.key = 0;
+			cursor.frame = deltas[0];
+		}
+
+		while (cursor.key + 1 < track.numKeys && frame >= cursor.frame + deltas[cursor.key + 1]) {
+			cursor.frame += deltas[++cursor.key];
+		}
+
+		int next = std::min(cursor.key + 1, track.numKeys - 1);
+		int span = next > cursor.key ? deltas[next] : 0;
+		float t = span ? std::min(std::max((frame - cursor.frame) / span, 0.0f), 1.0f) : 0.0f;
+
+		const uint16_t* a = &values[cursor.key * 3];
+		const uint16_t* b = &values[next * 3];
+
+		if (track.type == CLIP_TRANSLATION) {
+			ClipRange range;
+			memcpy(&range, &clip[track.offset], sizeof(range));
+
+			for (int c = 0; c < 3; c++) {
+				float va = (int16_t)a[c] / 32767.0f;
+				float vb = (int16_t)b[c] / 32767.0f;
+				pose.translation[c] = range.center[c] + (va + (vb - va) * t) * range.extent[c];
+			}
+			continue;
+		}
+
+		//nlerp along the shorter arc
+		float qa[4], qb[4];
+		unpackQuat(a, qa);
+		unpackQuat(b, qb);
+
+		float dot = qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3];
+		float sign = dot < 0.0f ? -1.0f : 1.0f;
+		float* q = &pose.rotations[track.joint * 4];
+		float length = 0.0f;
+
+		for (int c = 0; c < 4; c++) {
+			q[c] = qa[c] + (qb[c] * sign - qa[c]) * t;
+			length += q[c] * q[c];
+		}
+
+		length = sqrtf(length);
+		for (int c = 0; c < 4; c++) q[c] /= length;
+	}
+}
+
+//the key at or before frame and the one after, interpolated as the sampler does
+template <typename Key>
+static
+void keySpan(const std::vector<Key>& keys, float frame, int& key, int& next, float& t) {
+	auto it = std::upper_bound(keys.begin(), keys.end(), frame, [](float f, const Key& k) { return f < k.keyframe; });
+	key = std::max((int)(it - keys.begin()) - 1, 0);
+	next = std::min(key + 1, (int)keys.size() - 1);
+
+	int span = keys[next].keyframe - keys[key].keyframe;
+	t = span ? std::min(std::max((frame - keys[key].keyframe) / span, 0.0f), 1.0f) : 0.0f;
+}
+
+static
+void normalize(float* q) {
+	float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (int c = 0; c < 4; c++) q[c] /= length;
+}
+
+ClipError measureClip(const uint8_t* clip, const OarMotion& motion) {
+	ClipError error;
+	ClipSampler sampler(clip);
+	ClipPose pose;
+	int key, next;
+	float t;
+
+	for (int f = 0; f < std::max(sampler.numFrames(), 1); f++) {
+		sampler.sample((float)f, pose);
+
+		if (!motion.move.empty()) {
+			keySpan(motion.move, (float)f, key, next, t);
+			const OarMoveKey& a = motion.move[key];
+			const OarMoveKey& b = motion.move[next];
+			float ref[3] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t };
+
+			for (int c = 0; c < 3; c++) error.translation = std::max(error.translation, fabsf(ref[c] - pose.translation[c]));
+		}
+
+		for (int j = 0; j < motion.rotation.size(); j++) {
+			const std::vector<OarRotKey>& rot = motion.rotation[j];
+			if (rot.empty()) continue;
+
+			keySpan(rot, (float)f, key, next, t);
+			float qa[4] = { rot[key].x, rot[key].y, rot[key].z, rot[key].w };
+			float qb[4] = { rot[next].x, rot[next].y, rot[next].z, rot[next].w };
+			normalize(qa);
+			normalize(qb);
+
+			float dot = qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3];
+			float sign = dot < 0.0f ? -1.0f : 1.0f;
+			float ref[4];
+			for (int c = 0; c < 4; c++) ref[c] = qa[c] + (qb[c] * sign - qa[c]) * t;
+			normalize(ref);
+
+			const float* q = &pose.rotations[j * 4];
+			float cosHalf = fabsf(ref[0] * q[0] + ref[1] * q[1] + ref[2] * q[2] + ref[3] * q[3]);
+			float degrees = 2.0f * acosf(std::min(cosHalf, 1.0f)) * 57.29578f;
+			error.rotation = std::max(error.rotation, degrees);
+		}
+	}
+
+	return error;
+}
\ No newline at end of file
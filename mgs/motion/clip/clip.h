@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <inttypes.h>
+#include "../oar/oarmotion.h"
+
+//one motion packed for playback: key times as frame deltas, rotations as smallest three quaternions
+//in 48 bits and translations as int16 within each track's range. the track table follows the header,
+//then for each track its ClipRange if it's a translation, its deltas padded to 2 bytes and 3 16 bit values per key
+struct ClipHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t numTracks;
+	uint16_t numFrames;
+	uint16_t frameRate;
+	uint32_t size;
+};
+
+enum ClipTrackType {
+	CLIP_ROTATION,
+	CLIP_TRANSLATION
+};
+
+struct ClipTrack {
+	uint8_t  type;
+	uint8_t  joint;
+	uint16_t numKeys;
+	uint32_t offset; //from the start of the clip
+};
+
+//a translation value is center + q / 32767 * extent
+struct ClipRange {
+	float center[3];
+	float extent[3];
+};
+
+//false if a key lands more than 255 frames after the last, which oar streams can't produce
+bool encodeClip(const OarMotion& motion, std::vector<uint8_t>& clip);
+bool validateClip(const uint8_t* data, int size);
+
+//joint rotations as x, y, z, w and the root's translation, in the same space as OarMotion's keys
+struct ClipPose {
+	std::vector<float> rotations;
+	float translation[3];
+};
+
+//reads a validated clip in place. each track remembers the key it was last on,
+//so playing forwards only steps over the keys passed since the last sample
+class ClipSampler {
+public:
+	ClipSampler(const uint8_t* clip);
+
+	int numJoints() const;
+	int numFrames() const;
+	void sample(float frame, ClipPose& pose);
+private:
+	struct Cursor {
+		int key;
+		int frame;
+	};
+
+	size_t keyOffset(const ClipTrack& track) const;
+	const ClipHeader* header() const;
+	const ClipTrack* tracks() const;
+
+	const uint8_t* clip;
+	int joints;
+	std::vector<Cursor> cursors;
+};
+
+//largest difference between a clip and the motion it was encoded from, sampled at every frame
+struct ClipError {
+	float rotation = 0.0f;    //degrees
+	float translation = 0.0f;
+};
+
+ClipError measureClip(const uint8_t* clip, const OarMotion& motion);
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "oar.h"
+
+bool validateOar(const uint8_t* data, int size) {
+	if (!data || size < (int)sizeof(OarHeader)) return false;
+
+	const OarHeader* header = (const OarHeader*)data;
+	if (header->magic != 0x6152414F) return false;
+	if (header->maxJoint > 0xFF) return false;
+
+	uint64_t tableEntrySize = (header->maxJoint + 2) * 2;
+	uint64_t oarTableSize = tableEntrySize * header->numMotion;
+	return sizeof(OarHeader) + oarTableSize <= (uint64_t)size;
+}
\ No newline at end of file
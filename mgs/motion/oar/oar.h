@@ -12,4 +12,6 @@ struct OarHeader {
 struct ArchiveTable {
 	uint16_t numFrames;
 	uint16_t archiveOffset[]; // for numJoints + 1;
-};
\ No newline at end of file
+};
+
+bool validateOar(const uint8_t* data, int size);
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "oarindex.h"
+#include <fstream>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+//listed outside the lock, two workers racing on one directory both scan it and one listing wins
+std::vector<OarIndexEntry> OarIndex::scan(const fs::path& dir) {
+	std::error_code ec;
+	fs::file_time_type modified = fs::last_write_time(dir, ec);
+	if (ec) return {};
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = listings.find(dir);
+		if (it != listings.end() && it->second.modified == modified) return it->second.entries;
+	}
+
+	Listing listing;
+	listing.modified = modified;
+
+	for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+		if (it->path().extension() != ".oar" || !it->is_regular_file(ec)) continue;
+
+		uintmax_t size = it->file_size(ec);
+		if (ec || size > INT32_MAX) continue;
+
+		OarIndexEntry entry;
+		entry.path = it->path();
+
+		std::ifstream fs(entry.path, std::ios::binary);
+		if (!fs.read((char*)&entry.header, sizeof(OarHeader))) continue;
+
+		//validateOar only reads the header, the file's size stands in for the rest
+		if (validateOar((const uint8_t*)&entry.header, (int)size)) listing.entries.push_back(entry);
+	}
+
+	std::sort(listing.entries.begin(), listing.entries.end(), [](const OarIndexEntry& a, const OarIndexEntry& b) {
+		return a.path < b.path;
+	});
+
+	std::lock_guard<std::mutex> lock(mutex);
+	listings[dir] = listing;
+	return listing.entries;
+}
+
+std::vector<OarIndexEntry> OarIndex::compatible(const fs::path& model, int numBones) {
+	std::vector<OarIndexEntry> entries;
+	fs::path dir = model.parent_path();
+	if (dir.empty()) dir = ".";
+
+	for (const OarIndexEntry& entry : scan(dir)) {
+		if (entry.header.maxJoint <= (uint32_t)numBones && entry.header.numMotion) entries.push_back(entry);
+	}
+
+	fs::path stem = model.stem();
+	std::stable_sort(entries.begin(), entries.end(), [&](const OarIndexEntry& a, const OarIndexEntry& b) {
+		bool aNamed = a.path.stem() == stem;
+		bool bNamed = b.path.stem() == stem;
+		if (aNamed != bNamed) return aNamed;
+		return a.header.maxJoint > b.header.maxJoint;
+	});
+
+	return entries;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <vector>
+#include <filesystem>
+#include "oar.h"
+
+struct OarIndexEntry {
+	std::filesystem::path path;
+	OarHeader header;
+};
+
+//headers of the .oar files in each directory asked about, read once and kept until the directory changes
+class OarIndex {
+public:
+	//archives beside the model whose joints fit numBones, best first: the one sharing the model's name,
+	//then the closest joint count, then by path
+	std::vector<OarIndexEntry> compatible(const std::filesystem::path& model, int numBones);
+private:
+	struct Listing {
+		std::filesystem::file_time_type modified;
+		std::vector<OarIndexEntry> entries;
+	};
+
+	std::vector<OarIndexEntry> scan(const std::filesystem::path& dir);
+
+	std::mutex mutex;
+	std::map<std::filesystem::path, Listing> listings;
+};
\ No newline at end of file
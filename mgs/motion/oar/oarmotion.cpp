@@ -0,0 +1,135 @@
+#include "oarmotion.h"
+#include <math.h>
+#include "../../common/bitstream.h"
+#include "../../common/memstats.h"
+
+static const double PI = acos(-1);
+
+static
+void eulerToQuat(double ex, double ey, double ez, OarRotKey& key) {
+	double cy = cos(ez * 0.5);
+	double sy = sin(ez * 0.5);
+	double cp = cos(ey * 0.5);
+	double sp = sin(ey * 0.5);
+	double cr = cos(ex * 0.5);
+	double sr = sin(ex * 0.5);
+
+	key.x = sr * cp * cy - cr * sp * sy;
+	key.y = cr * sp * cy + sr * cp * sy;
+	key.z = cr * cp * sy - sr * sp * cy;
+	key.w = cr * cp * cy + sr * sp * sy;
+}
+
+static
+std::vector<OarRotKey> readRotBitstream(BitReader bs, int numFrames) {
+	int keyFrame = 0;
+	std::vector<OarRotKey> ra;
+
+	int xL = bs.readBits(4);
+	int yL = bs.readBits(4);
+	int zL = bs.readBits(4);
+
+	while (keyFrame < numFrames && !bs.atEnd()) {
+		keyFrame += bs.readBits(4);
+		bs.readBits(4); //unknown
+
+		int32_t x = bs.readSigned(xL);
+		int32_t y = bs.readSigned(yL);
+		int32_t z = bs.readSigned(zL);
+
+		OarRotKey key;
+		key.keyframe = keyFrame;
+		eulerToQuat(x / 2047.0 * PI, y / 2047.0 * PI, z / 2047.0 * PI, key);
+		ra.push_back(key);
+	}
+
+	return ra;
+}
+
+static
+std::vector<OarMoveKey> readMoveBitstream(BitReader bs, int numFrames) {
+	int keyFrame = 0;
+	std::vector<OarMoveKey> ma;
+
+	int32_t y = bs.readBits(16);
+	if (y & 0x800) { y |= -0x1000; }
+	float originY = y;
+	ma.push_back({ keyFrame, 0, originY, 0 });
+
+	int xL = bs.readBits(4);
+	int yL = bs.readBits(4);
+	int zL = bs.readBits(4);
+	bs.readBits(4); //unknown
+
+	if (!xL && !yL && !zL) {
+		return ma;
+	}
+
+	while (keyFrame < numFrames && !bs.atEnd()) {
+		keyFrame++; //not sure what determines keyframe, still need to look into it
+		int32_t x = bs.readSigned(xL);
+		int32_t y = bs.readSigned(yL);
+		int32_t z = bs.readSigned(zL);
+
+		float fy = originY + y;
+		float fx = x / 2047.0f * PI;
+		float fz = z / 2047.0f * PI;
+
+		ma.push_back({ keyFrame, fx, fy, fz });
+	}
+
+	return ma;
+}
+
+int oarNumMotion(const uint8_t* data) {
+	return ((const OarHeader*)data)->numMotion;
+}
+
+int oarNumJoints(const uint8_t* data) {
+	return ((const OarHeader*)data)->maxJoint;
+}
+
+//expects data to have passed validateOar
+bool decodeOarMotion(const uint8_t* data, int size, int motionIdx, OarMotion& motion) {
+	const OarHeader* header = (const OarHeader*)data;
+	if (motionIdx < 0 || motionIdx >= header->numMotion) return false;
+
+	int tableEntrySize = (header->maxJoint + 2) * 2;
+	int oarTableSize = tableEntrySize * header->numMotion;
+	const uint8_t* archive = &data[sizeof(OarHeader) + oarTableSize];
+	size_t archiveLen = size - sizeof(OarHeader) - oarTableSize;
+
+	const ArchiveTable* table = (const ArchiveTable*)&data[sizeof(OarHeader) + motionIdx * tableEntrySize];
+	releaseOarMotion(motion);
+	motion.numFrames = table->numFrames;
+
+	for (int j = 0; j < header->maxJoint + 1; j++) {
+		//tracks read so far haven't been counted yet, so they're dropped without a release
+		size_t offset = table->archiveOffset[j] * 2;
+		if (offset >= archiveLen) {
+			motion = OarMotion();
+			return false;
+		}
+
+		//streams are only bounded by the archive, not by their own length
+		size_t streamLen = header->archiveSize * 2;
+		if (streamLen > archiveLen - offset) streamLen = archiveLen - offset;
+		BitReader bs(&archive[offset], streamLen);
+
+		if (j == 0) {
+			motion.move = readMoveBitstream(bs, motion.numFrames);
+		} else {
+			motion.rotation.push_back(readRotBitstream(bs, motion.numFrames));
+		}
+	}
+
+	memCount(MEM_MOTION, motion.move.capacity() * sizeof(OarMoveKey));
+	for (const std::vector<OarRotKey>& rot : motion.rotation) memCount(MEM_MOTION, rot.capacity() * sizeof(OarRotKey));
+	return true;
+}
+
+void releaseOarMotion(OarMotion& motion) {
+	memRelease(motion.move.capacity() * sizeof(OarMoveKey));
+	for (const std::vector<OarRotKey>& rot : motion.rotation) memRelease(rot.capacity() * sizeof(OarRotKey));
+	motion = OarMotion();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include "oar.h"
+
+struct OarMoveKey {
+	int keyframe;
+	float x;
+	float y;
+	float z;
+};
+
+//rotations are stored as quaternions converted from the packed euler angles
+struct OarRotKey {
+	int keyframe;
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+struct OarMotion {
+	int numFrames = 0;
+	std::vector<OarMoveKey> move;                 //root only
+	std::vector<std::vector<OarRotKey>> rotation; //one track per joint
+};
+
+const float g_oarFrameRate = 30.0f;
+
+int oarNumMotion(const uint8_t* data);
+int oarNumJoints(const uint8_t* data);
+//keys already in motion are released first, so one motion can be decoded into repeatedly
+bool decodeOarMotion(const uint8_t* data, int size, int motionIdx, OarMotion& motion);
+//frees the keys and takes them off the memory stats
+void releaseOarMotion(OarMotion& motion);
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include "bvh.h"
+#include <math.h>
+#include <numeric>
+#include <algorithm>
+#include "../../model/kmd/kmdskeleton.h"
+
+static const int MAX_LEAF_ITEMS = 4;
+
+bool Bounds::isEmpty() const {
+	return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+}
+
+void Bounds::grow(const float* point) {
+	for (int c = 0; c < 3; c++) {
+		min[c] = std::min(min[c], point[c]);
+		max[c] = std::max(max[c], point[c]);
+	}
+}
+
+void Bounds::grow(const Bounds& other) {
+	if (other.isEmpty()) return;
+	grow(other.min);
+	grow(other.max);
+}
+
+Frustum frustumFromMatrix(const float* m) {
+	Frustum frustum;
+
+	//rows of the column major matrix, each plane is the last row plus or minus one of the others
+	for (int i = 0; i < 3; i++) {
+		for (int c = 0; c < 4; c++) {
+			frustum.planes[i * 2 + 0][c] = m[c * 4 + 3] + m[c * 4 + i];
+			frustum.planes[i * 2 + 1][c] = m[c * 4 + 3] - m[c * 4 + i];
+		}
+	}
+
+	return frustum;
+}
+
+bool rayHitsBounds(const Ray& ray, const Bounds& bounds, float maxT, float& t) {
+	float enter = 0.0f;
+	float exit = maxT;
+
+	for (int c = 0; c < 3; c++) {
+		if (ray.dir[c] == 0.0f) {
+			if (ray.origin[c] < bounds.min[c] || ray.origin[c] > bounds.max[c]) return false;
+			continue;
+		}
+
+		float inv = 1.0f / ray.dir[c];
+		float t0 = (bounds.min[c] - ray.origin[c]) * inv;
+		float t1 = (bounds.max[c] - ray.origin[c]) * inv;
+		if (t0 > t1) std::swap(t0, t1);
+
+		enter = std::max(enter, t0);
+		exit = std::min(exit, t1);
+		if (enter > exit) return false;
+	}
+
+	t = enter;
+	return true;
+}
+
+//the corner furthest along each plane's normal decides whether the box is wholly outside it
+bool frustumHitsBounds(const Frustum& frustum, const Bounds& bounds) {
+	for (const float* plane : frustum.planes) {
+		float d = plane[3];
+		for (int c = 0; c < 3; c++) d += plane[c] * (plane[c] >= 0.0f ? bounds.max[c] : bounds.min[c]);
+		if (d < 0.0f) return false;
+	}
+
+	return true;
+}
+
+static
+void buildNode(Bvh& bvh, uint32_t n, const std::vector<Bounds>& boxes, const std::vector<float>& centroids) {
+	uint32_t first = bvh.nodes[n].first;
+	uint32_t count = bvh.nodes[n].count;
+
+	Bounds bounds, centroidBounds;
+	for (uint32_t i = first; i < first + count; i++) {
+		bounds.grow(boxes[bvh.items[i]]);
+		centroidBounds.grow(&centroids[bvh.items[i] * 3]);
+	}
+
+	bvh.nodes[n].bounds = bounds;
+	if (count <= MAX_LEAF_ITEMS) return;
+
+	int axis = 0;
+	for (int c = 1; c < 3; c++) {
+		if (centroidBounds.max[c] - centroidBounds.min[c] > centroidBounds.max[axis] - centroidBounds.min[axis]) axis = c;
+	}
+
+	//every centroid in one spot, splitting wouldn't separate anything
+	if (centroidBounds.max[axis] <= centroidBounds.min[axis]) return;
+
+	uint32_t mid = first + count / 2;
+	std::nth_element(bvh.items.begin() + first, bvh.items.begin() + mid, bvh.items.begin() + first + count, [&](uint32_t a, uint32_t b) {
+		return centroids[a * 3 + axis] < centroids[b * 3 + axis];
+	});
+
+	uint32_t left = bvh.nodes.size();
+	bvh.nodes.push_back({ Bounds(), first, mid - first });
+	bvh.nodes.push_back({ Bounds(), mid, first + count - mid });
+	bvh.nodes[n].first = left;
+	bvh.nodes[n].count = 0;
+
+	buildNode(bvh, left, boxes, centroids);
+	buildNode(bvh, left + 1, boxes, centroids);
+}
+
+//empty boxes can't be hit or seen, they're left out
+void Bvh::build(const std::vector<Bounds>& boxes) {
+	nodes.clear();
+	items.clear();
+
+	std::vector<float> centroids(boxes.size() * 3);
+	for (uint32_t i = 0; i < boxes.size(); i++) {
+		if (boxes[i].isEmpty()) continue;
+
+		items.push_back(i);
+		for (int c = 0; c < 3; c++) centroids[i * 3 + c] = (boxes[i].min[c] + boxes[i].max[c]) * 0.5f;
+	}
+
+	if (items.empty()) return;
+
+	nodes.reserve(items.size() * 2);
+	nodes.push_back({ Bounds(), 0, (uint32_t)items.size() });
+	buildNode(*this, 0, boxes, centroids);
+}
+
+bool Bvh::isEmpty() const {
+	return nodes.empty();
+}
+
+const Bounds& Bvh::bounds() const {
+	static const Bounds empty;
+	return nodes.empty() ? empty : nodes[0].bounds;
+}
+
+void Bvh::raycast(const Ray& ray, float maxT, const std::function<float(uint32_t item, float maxT)>& visit) const {
+	float t;
+	if (nodes.empty() || !rayHitsBounds(ray, nodes[0].bounds, maxT, t)) return;
+
+	std::vector<std::pair<float, uint32_t>> stack;
+	stack.push_back({ t, 0 });
+
+	while (!stack.empty()) {
+		std::pair<float, uint32_t> entry = stack.back();
+		stack.pop_back();
+		if (entry.first > maxT) continue;
+
+		const Node& node = nodes[entry.second];
+		if (node.count) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) maxT = visit(items[i], maxT);
+			continue;
+		}
+
+		float tl, tr;
+		bool hitLeft = rayHitsBounds(ray, nodes[node.first].bounds, maxT, tl);
+		bool hitRight = rayHitsBounds(ray, nodes[node.first + 1].bounds, maxT, tr);
+
+		//the nearer child goes on last so it's visited first
+		if (hitLeft && hitRight && tl < tr) {
+			stack.push_back({ tr, node.first + 1 });
+			stack.push_back({ tl, node.first });
+		} else {
+			if (hitLeft) stack.push_back({ tl, node.first });
+			if (hitRight) stack.push_back({ tr, node.first + 1 });
+		}
+	}
+}
+
+void Bvh::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+	if (nodes.empty()) return;
+
+	std::vector<uint32_t> stack;
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (!frustumHitsBounds(frustum, node.bounds)) continue;
+
+		if (node.count) {
+			visible.insert(visible.end(), items.begin() + node.first, items.begin() + node.first + node.count);
+		} else {
+			stack.push_back(node.first + 1);
+			stack.push_back(node.first);
+		}
+	}
+}
+
+//two sided moller trumbore
+static
+bool rayHitsTriangle(const Ray& ray, const float* v0, const float* v1, const float* v2, float& t) {
+	float e1[3], e2[3], s[3], p[3], q[3];
+	for (int c = 0; c < 3; c++) {
+		e1[c] = v1[c] - v0[c];
+		e2[c] = v2[c] - v0[c];
+		s[c] = ray.origin[c] - v0[c];
+	}
+
+	auto cross = [](const float* a, const float* b, float* out) {
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	};
+	auto dot = [](const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+
+	cross(ray.dir, e2, p);
+	float det = dot(e1, p);
+	if (fabsf(det) < 1e-12f) return false;
+
+	float inv = 1.0f / det;
+	float u = dot(s, p) * inv;
+	if (u < 0.0f || u > 1.0f) return false;
+
+	cross(s, e1, q);
+	float v = dot(ray.dir, q) * inv;
+	if (v < 0.0f || u + v > 1.0f) return false;
+
+	t = dot(e2, q) * inv;
+	return t >= 0.0f;
+}
+
+void MeshBvh::build(const KmdGeometry& geo) {
+	size_t numTris = geo.indices.size() / 3;
+	std::vector<Bounds> boxes(numTris);
+	corners.resize(numTris * 9);
+
+	for (size_t i = 0; i < numTris * 3; i++) {
+		uint32_t v = geo.indices[i];
+		float* corner = &corners[i * 3];
+
+		for (int c = 0; c < 3; c++) {
+			corner[c] = geo.quantized ? geo.shortPositions[v * 3 + c] : geo.positions[v * 3 + c];
+		}
+
+		boxes[i / 3].grow(corner);
+	}
+
+	bvh.build(boxes);
+}
+
+const Bounds& MeshBvh::bounds() const {
+	return bvh.bounds();
+}
+
+bool MeshBvh::pick(const Ray& ray, float& t, uint32_t& triangle) const {
+	bool hit = false;
+
+	bvh.raycast(ray, t, [&](uint32_t tri, float maxT) {
+		const float* v = &corners[tri * 9];
+		float hitT;
+
+		if (rayHitsTriangle(ray, v, v + 3, v + 6, hitT) && hitT < maxT) {
+			maxT = t = hitT;
+			triangle = tri;
+			hit = true;
+		}
+
+		return maxT;
+	});
+
+	return hit;
+}
+
+static
+Bounds offsetBounds(const Bounds& bounds, const float* offset) {
+	Bounds result = bounds;
+	if (result.isEmpty()) return result;
+
+	for (int c = 0; c < 3; c++) {
+		result.min[c] += offset[c];
+		result.max[c] += offset[c];
+	}
+
+	return result;
+}
+
+static
+Bounds kmdBounds(const Vec3Long& min, const Vec3Long& max) {
+	Bounds bounds;
+	if (min.x > max.x || min.y > max.y || min.z > max.z) return bounds;
+
+	float lo[3] = { (float)min.x, (float)min.y, (float)min.z };
+	float hi[3] = { (float)max.x, (float)max.y, (float)max.z };
+	bounds.grow(lo);
+	bounds.grow(hi);
+	return bounds;
+}
+
+//mesh boxes in the kmd are in the mesh's own space like its vertices, the header's box is in model space
+int SceneBvh::addModel(const KmdView& kmd, const std::vector<const KmdGeometry*>& geometry) {
+	Span<const KmdMesh> kmdMeshes = kmd.meshes();
+	KmdSkeleton skeleton;
+	buildKmdSkeleton(kmd, skeleton);
+	Model model;
+
+	for (int i = 0; i < kmdMeshes.size(); i++) {
+		Mesh mesh;
+		mesh.shape = -1;
+		skeleton.worldTranslation(i, mesh.offset);
+
+		const KmdGeometry* geo = i < geometry.size() ? geometry[i] : NULL;
+		if (geo && !geo->indices.empty()) {
+			auto it = shapeIdx.find(geo);
+			if (it == shapeIdx.end()) {
+				shapes.emplace_back();
+				shapes.back().build(*geo);
+				it = shapeIdx.emplace(geo, (int)shapes.size() - 1).first;
+			}
+
+			mesh.shape = it->second;
+			mesh.bounds = offsetBounds(shapes[mesh.shape].bounds(), mesh.offset);
+		} else {
+			mesh.bounds = offsetBounds(kmdBounds(kmdMeshes[i].min, kmdMeshes[i].max), mesh.offset);
+		}
+
+		model.bounds.grow(mesh.bounds);
+		model.meshes.push_back(mesh);
+	}
+
+	if (model.bounds.isEmpty()) model.bounds = kmdBounds(kmd.header()->min, kmd.header()->max);
+
+	models.push_back(std::move(model));
+	return models.size() - 1;
+}
+
+void SceneBvh::build() {
+	std::vector<Bounds> boxes;
+
+	for (Model& model : models) {
+		boxes.clear();
+		for (const Mesh& mesh : model.meshes) boxes.push_back(mesh.bounds);
+		model.bvh.build(boxes);
+	}
+
+	boxes.clear();
+	for (const Model& model : models) boxes.push_back(model.bounds);
+	bvh.build(boxes);
+}
+
+const Bounds& SceneBvh::bounds() const {
+	return bvh.bounds();
+}
+
+const Bounds& SceneBvh::modelBounds(int model) const {
+	return models[model].bounds;
+}
+
+bool SceneBvh::pick(const Ray& ray, ScenePick& hit) const {
+	bool found = false;
+
+	bvh.raycast(ray, 1e30f, [&](uint32_t m, float maxT) {
+		const Model& model = models[m];
+
+		model.bvh.raycast(ray, maxT, [&](uint32_t i, float meshMaxT) {
+			const Mesh& mesh = model.meshes[i];
+			if (mesh.shape < 0) return meshMaxT;
+
+			Ray local = ray;
+			for (int c = 0; c < 3; c++) local.origin[c] -= mesh.offset[c];
+
+			float t = meshMaxT;
+			uint32_t triangle;
+			if (!shapes[mesh.shape].pick(local, t, triangle)) return meshMaxT;
+
+			hit = { (int)m, (int)i, triangle, t };
+			found = true;
+			return t;
+		});
+
+		return found ? hit.t : maxT;
+	});
+
+	return found;
+}
+
+void SceneBvh::cull(const Frustum& frustum, std::vector<SceneMesh>& visible) const {
+	std::vector<uint32_t> visibleModels, visibleMeshes;
+	bvh.cull(frustum, visibleModels);
+
+	for (uint32_t m : visibleModels) {
+		visibleMeshes.clear();
+		models[m].bvh.cull(frustum, visibleMeshes);
+		for (uint32_t i : visibleMeshes) visible.push_back({ (int)m, (int)i });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <functional>
+#include "../../model/kmd/kmdgeometry.h"
+
+struct Bounds {
+	float min[3] = {  1e30f,  1e30f,  1e30f };
+	float max[3] = { -1e30f, -1e30f, -1e30f };
+
+	bool isEmpty() const;
+	void grow(const float* point);
+	void grow(const Bounds& other);
+};
+
+struct Ray {
+	float origin[3];
+	float dir[3];
+};
+
+//planes face inwards, a point is inside when dot(plane, point) + plane[3] >= 0 for all six
+struct Frustum {
+	float planes[6][4];
+};
+
+//column major view projection as gltf and opengl use it, clip space z in -w..w
+Frustum frustumFromMatrix(const float* viewProj);
+//distance along the ray to where it enters bounds, false if it misses or only enters after maxT
+bool rayHitsBounds(const Ray& ray, const Bounds& bounds, float maxT, float& t);
+//conservative, boxes near a corner of the frustum can pass without being visible
+bool frustumHitsBounds(const Frustum& frustum, const Bounds& bounds);
+
+//binary tree over boxes, split at the centroid median of the longest axis with up to 4 items a leaf
+class Bvh {
+public:
+	struct Node {
+		Bounds bounds;
+		uint32_t first; //first of items for leaves, left child for inner nodes with the right one after it
+		uint32_t count; //0 for inner nodes
+	};
+
+	void build(const std::vector<Bounds>& boxes);
+	bool isEmpty() const;
+	const Bounds& bounds() const;
+
+	//visits the items whose boxes the ray enters before maxT, nearer boxes first. visit returns the new maxT
+	void raycast(const Ray& ray, float maxT, const std::function<float(uint32_t item, float maxT)>& visit) const;
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> items;
+};
+
+//triangles of one decoded mesh, in the mesh's own space
+class MeshBvh {
+public:
+	void build(const KmdGeometry& geo);
+	const Bounds& bounds() const;
+	//nearest triangle hit before t, both sides count. t is moved up to the hit
+	bool pick(const Ray& ray, float& t, uint32_t& triangle) const;
+private:
+	Bvh bvh;
+	std::vector<float> corners; //9 floats a triangle, positions copied out of either stream
+};
+
+struct SceneMesh {
+	int model;
+	int mesh;
+};
+
+struct ScenePick {
+	int model;
+	int mesh;
+	uint32_t triangle; //in the mesh's geometry, index / 3
+	float t;
+};
+
+//the meshes of one model or a whole stage in model space, a tree of models with a tree of meshes under each.
+//boxes start as the kmd bounds and are tightened to the triangles of meshes that come with geometry
+class SceneBvh {
+public:
+	//geometry is one entry per kmd mesh, empty or NULL entries keep the kmd's box and can't be picked.
+	//geometry is only read here, meshes sharing one KmdGeometry share its triangle tree
+	int addModel(const KmdView& kmd, const std::vector<const KmdGeometry*>& geometry = {});
+	void build();
+
+	const Bounds& bounds() const;
+	const Bounds& modelBounds(int model) const;
+	bool pick(const Ray& ray, ScenePick& hit) const;
+	void cull(const Frustum& frustum, std::vector<SceneMesh>& visible) const;
+private:
+	struct Mesh {
+		Bounds bounds;
+		float offset[3];
+		int shape; //into shapes, -1 without geometry
+	};
+
+	struct Model {
+		Bounds bounds;
+		std::vector<Mesh> meshes;
+		Bvh bvh;
+	};
+
+	std::vector<Model> models;
+	std::vector<MeshBvh> shapes;
+	std::map<const KmdGeometry*, int> shapeIdx;
+	Bvh bvh;
+};
\ No newline at end of file
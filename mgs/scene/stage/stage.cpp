@@ -0,0 +1,87 @@
+#include "stage.h"
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+StageIndex scanStage(const fs::path& dir) {
+	StageIndex stage;
+	stage.dir = dir;
+
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+		if (!it->is_regular_file(ec)) continue;
+
+		fs::path ext = it->path().extension();
+		if (ext == ".kmd") stage.models.push_back(it->path());
+		else if (ext == ".dar") stage.archives.push_back(it->path());
+	}
+
+	std::sort(stage.models.begin(), stage.models.end());
+	std::sort(stage.archives.begin(), stage.archives.end());
+	return stage;
+}
+
+std::vector<StageModel> readStageModels(const StageIndex& stage) {
+	std::vector<StageModel> models;
+
+	for (const fs::path& path : stage.models) {
+		std::error_code ec;
+		uintmax_t size = fs::file_size(path, ec);
+		if (ec || size > INT32_MAX) continue;
+
+		StageModel model;
+		model.path = path;
+		model.data.resize(size);
+
+		std::ifstream fs(path, std::ios::binary);
+		fs.read((char*)model.data.data(), size);
+		if (!fs || !validateKmd(model.data.data(), size)) continue;
+
+		models.push_back(std::move(model));
+	}
+
+	return models;
+}
+
+std::string stageModelName(const StageIndex& stage, const StageModel& model) {
+	std::error_code ec;
+	fs::path rel = fs::relative(model.path, stage.dir, ec);
+	if (ec || rel.empty()) rel = model.path.filename();
+
+	return rel.replace_extension().generic_u8string();
+}
+
+StageGeometry decodeStage(const std::vector<StageModel>& models, ThreadPool* pool, bool quantized) {
+	StageGeometry geometry;
+	geometry.instances.resize(models.size());
+
+	std::unordered_map<uint64_t, int> keys;
+	std::vector<std::pair<int, int>> sources; //model and mesh each unique mesh decodes from
+
+	for (int i = 0; i < models.size(); i++) {
+		KmdView kmd(models[i].data.data(), models[i].data.size());
+
+		for (int j = 0; j < kmd.numMesh(); j++) {
+			auto it = keys.emplace(kmdMeshKey(kmd, j), (int)sources.size());
+			if (it.second) sources.push_back({ i, j });
+			geometry.instances[i].push_back(it.first->second);
+		}
+	}
+
+	geometry.meshes.resize(sources.size());
+	auto decode = [&](int k) {
+		const StageModel& model = models[sources[k].first];
+		decodeKmdMesh(KmdView(model.data.data(), model.data.size()), sources[k].second, geometry.meshes[k], quantized);
+	};
+
+	if (pool) {
+		pool->parallelFor(sources.size(), decode);
+	} else {
+		for (int k = 0; k < sources.size(); k++) decode(k);
+	}
+
+	for (const KmdGeometry& geo : geometry.meshes) countKmdGeometry(geo);
+	return geometry;
+}
\ No newline at end of file
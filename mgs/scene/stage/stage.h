@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <inttypes.h>
+#include "../../model/kmd/kmdgeometry.h"
+
+//models and archives under a stage directory, listed in a single pass and sorted by path
+struct StageIndex {
+	std::filesystem::path dir;
+	std::vector<std::filesystem::path> models;
+	std::vector<std::filesystem::path> archives;
+};
+
+struct StageModel {
+	std::filesystem::path path;
+	std::vector<uint8_t> data;
+};
+
+StageIndex scanStage(const std::filesystem::path& dir);
+
+//models that can't be read or aren't valid kmd are left out
+std::vector<StageModel> readStageModels(const StageIndex& stage);
+
+//path relative to the stage without extension, unique within it
+std::string stageModelName(const StageIndex& stage, const StageModel& model);
+
+//meshes with the same kmdMeshKey are decoded once and shared by every model that places them
+struct StageGeometry {
+	std::vector<KmdGeometry> meshes;
+	std::vector<std::vector<int>> instances; //per model, index into meshes for each kmd mesh
+};
+
+StageGeometry decodeStage(const std::vector<StageModel>& models, ThreadPool* pool, bool quantized = false);
\ No newline at end of file
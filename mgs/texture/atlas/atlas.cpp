@@ -0,0 +1,134 @@
+#include "atlas.h"
+#include <algorithm>
+#include <string.h>
+
+SkylinePacker::SkylinePacker(int width, int height) {
+	this->width = width;
+	this->height = height;
+	this->skyline.push_back({ 0, 0, width });
+}
+
+//y is the lowest the rect can sit when its left edge is on segment idx
+bool SkylinePacker::fits(int idx, int width, int height, int& y) {
+	if (skyline[idx].x + width > this->width) return false;
+
+	int remaining = width;
+	y = 0;
+
+	for (int i = idx; remaining > 0; i++) {
+		if (i >= skyline.size()) return false;
+
+		y = std::max(y, skyline[i].y);
+		if (y + height > this->height) return false;
+		remaining -= skyline[i].width;
+	}
+
+	return true;
+}
+
+bool SkylinePacker::insert(int width, int height, int& x, int& y) {
+	int best = -1;
+	int bestY = 0;
+	int bestWidth = 0;
+
+	for (int i = 0; i < skyline.size(); i++) {
+		int segY;
+		if (!fits(i, width, height, segY)) continue;
+
+		if (best < 0 || segY + height < bestY + height || (segY == bestY && skyline[i].width < bestWidth)) {
+			best = i;
+			bestY = segY;
+			bestWidth = skyline[i].width;
+		}
+	}
+
+	if (best < 0) return false;
+
+	x = skyline[best].x;
+	y = bestY;
+
+	//the new segment covers the rect, whatever it shadows is trimmed or dropped
+	skyline.insert(skyline.begin() + best, { x, y + height, width });
+
+	for (int i = best + 1; i < skyline.size(); i++) {
+		int shrink = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+		if (shrink <= 0) break;
+
+		skyline[i].x += shrink;
+		skyline[i].width -= shrink;
+
+		if (skyline[i].width > 0) break;
+		skyline.erase(skyline.begin() + i--);
+	}
+
+	for (int i = 0; i + 1 < skyline.size(); i++) {
+		if (skyline[i].y != skyline[i + 1].y) continue;
+
+		skyline[i].width += skyline[i + 1].width;
+		skyline.erase(skyline.begin() + i-- + 1);
+	}
+
+	return true;
+}
+
+static
+void blit(const PcxImage& image, int padding, int x, int y, PcxImage& page) {
+	int width = image.width + padding * 2;
+	int height = image.height + padding * 2;
+
+	for (int row = 0; row < height; row++) {
+		int sy = std::min(std::max(row - padding, 0), image.height - 1);
+
+		for (int col = 0; col < width; col++) {
+			int sx = std::min(std::max(col - padding, 0), image.width - 1);
+			size_t src = (size_t)sy * image.width + sx;
+			size_t dst = (size_t)(y + row) * page.width + x + col;
+
+			memcpy(&page.pixels[dst * 4], pcxPixel(image, src), 4);
+			page.indices[dst] = image.indices[src];
+		}
+	}
+}
+
+void buildAtlas(const AtlasInput& images, int pageSize, int padding, TextureAtlas& atlas) {
+	atlas.pageSize = pageSize;
+	atlas.padding = padding;
+	atlas.pages.clear();
+	atlas.rects.clear();
+
+	std::vector<int> order;
+	for (int i = 0; i < images.size(); i++) {
+		const PcxImage& image = *images[i].second;
+		if (image.width + padding * 2 <= pageSize && image.height + padding * 2 <= pageSize) order.push_back(i);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return images[a].second->height > images[b].second->height; });
+
+	std::vector<SkylinePacker> packers;
+
+	for (int i : order) {
+		const PcxImage& image = *images[i].second;
+		int width = image.width + padding * 2;
+		int height = image.height + padding * 2;
+		int page = 0;
+		int x, y;
+
+		for (; page < packers.size(); page++) {
+			if (packers[page].insert(width, height, x, y)) break;
+		}
+
+		if (page == packers.size()) {
+			packers.push_back(SkylinePacker(pageSize, pageSize));
+			packers.back().insert(width, height, x, y);
+
+			PcxImage blank;
+			blank.width = blank.height = pageSize;
+			blank.pixels.resize((size_t)pageSize * pageSize * 4);
+			blank.indices.resize((size_t)pageSize * pageSize);
+			atlas.pages.push_back(std::move(blank));
+		}
+
+		blit(image, padding, x, y, atlas.pages[page]);
+		atlas.rects[images[i].first] = { page, x + padding, y + padding, image.width, image.height };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <memory>
+#include "../pcx/pcx.h"
+
+struct AtlasRect {
+	int page;
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+//bottom left skyline, one instance per page
+class SkylinePacker {
+public:
+	SkylinePacker(int width, int height);
+	bool insert(int width, int height, int& x, int& y);
+private:
+	struct Segment {
+		int x;
+		int y;
+		int width;
+	};
+
+	bool fits(int idx, int width, int height, int& y);
+
+	int width;
+	int height;
+	std::vector<Segment> skyline;
+};
+
+struct TextureAtlas {
+	int pageSize = 0;
+	int padding = 0;
+	std::vector<PcxImage> pages;
+	std::map<uint16_t, AtlasRect> rects;
+};
+
+typedef std::vector<std::pair<uint16_t, std::shared_ptr<const PcxImage>>> AtlasInput;
+
+//images are packed tallest first with their edges extended into the padding so filtering doesn't bleed
+void buildAtlas(const AtlasInput& images, int pageSize, int padding, TextureAtlas& atlas);
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "bc.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../../common/cpu.h"
+
+typedef void (*ColorBlockKernel)(const uint8_t* block, uint8_t* out);
+
+struct BlockKernels {
+	const char* name;
+	ColorBlockKernel color;
+};
+
+static
+uint16_t pack565(int r, int g, int b) {
+	return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static
+void unpack565(uint16_t c, int rgb[3]) {
+	int r = c >> 11;
+	int g = (c >> 5) & 0x3F;
+	int b = c & 0x1F;
+
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 3);
+}
+
+//bounding box endpoints inset by a sixteenth, as in van waveren's real-time dxt compression
+static
+void colorEndpoints(const int minColor[3], const int maxColor[3], uint16_t& c0, uint16_t& c1, int palette[4][3]) {
+	int lo[3], hi[3];
+
+	for (int c = 0; c < 3; c++) {
+		int inset = (maxColor[c] - minColor[c]) >> 4;
+		lo[c] = minColor[c] + inset;
+		hi[c] = maxColor[c] - inset;
+	}
+
+	c0 = pack565(hi[0], hi[1], hi[2]);
+	c1 = pack565(lo[0], lo[1], lo[2]);
+
+	unpack565(c0, palette[0]);
+	unpack565(c1, palette[1]);
+
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+static
+void writeColorBlock(uint16_t c0, uint16_t c1, uint32_t indices, uint8_t* out) {
+	//equal endpoints would select the 3 colour mode, every index 0 reads c0 in either mode
+	if (c0 == c1) indices = 0;
+
+	memcpy(out + 0, &c0, 2);
+	memcpy(out + 2, &c1, 2);
+	memcpy(out + 4, &indices, 4);
+}
+
+static
+void colorBlockScalar(const uint8_t* block, uint8_t* out) {
+	int minColor[3] = { 255, 255, 255 };
+	int maxColor[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			int v = block[i * 4 + 2 - c];
+			if (v < minColor[c]) minColor[c] = v;
+			if (v > maxColor[c]) maxColor[c] = v;
+		}
+	}
+
+	uint16_t c0, c1;
+	int palette[4][3];
+	colorEndpoints(minColor, maxColor, c0, c1, palette);
+
+	uint32_t indices = 0;
+
+	for (int i = 0; i < 16; i++) {
+		int best = 0;
+		int bestDist = 0x7FFFFFFF;
+
+		for (int p = 0; p < 4; p++) {
+			int dist = 0;
+			for (int c = 0; c < 3; c++) {
+				int d = block[i * 4 + 2 - c] - palette[p][c];
+				dist += d * d;
+			}
+
+			if (dist < bestDist) {
+				bestDist = dist;
+				best = p;
+			}
+		}
+
+		indices |= best << (i * 2);
+	}
+
+	writeColorBlock(c0, c1, indices, out);
+}
+
+#ifdef MGS_X86
+//same endpoints and nearest colour search as the scalar kernel, 4 pixels per register
+MGS_TARGET_SSE2 static
+void colorBlockSSE2(const uint8_t* block, uint8_t* out) {
+	__m128i px[4];
+	for (int i = 0; i < 4; i++) px[i] = _mm_loadu_si128((const __m128i*)&block[i * 16]);
+
+	__m128i lo = _mm_min_epu8(_mm_min_epu8(px[0], px[1]), _mm_min_epu8(px[2], px[3]));
+	__m128i hi = _mm_max_epu8(_mm_max_epu8(px[0], px[1]), _mm_max_epu8(px[2], px[3]));
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+
+	uint32_t loBits = _mm_cvtsi128_si32(lo);
+	uint32_t hiBits = _mm_cvtsi128_si32(hi);
+	int minColor[3] = { (int)(loBits >> 16) & 0xFF, (int)(loBits >> 8) & 0xFF, (int)loBits & 0xFF };
+	int maxColor[3] = { (int)(hiBits >> 16) & 0xFF, (int)(hiBits >> 8) & 0xFF, (int)hiBits & 0xFF };
+
+	uint16_t c0, c1;
+	int palette[4][3];
+	colorEndpoints(minColor, maxColor, c0, c1, palette);
+
+	__m128i zero = _mm_setzero_si128();
+	__m128i colors[4];
+	for (int p = 0; p < 4; p++) {
+		colors[p] = _mm_set_epi16(0, palette[p][0], palette[p][1], palette[p][2], 0, palette[p][0], palette[p][1], palette[p][2]);
+	}
+
+	//alpha is masked out so it never adds to the distance
+	__m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+	uint32_t indices = 0;
+
+	for (int i = 0; i < 4; i++) {
+		__m128i rgb = _mm_and_si128(px[i], rgbMask);
+		__m128i a = _mm_unpacklo_epi8(rgb, zero);
+		__m128i b = _mm_unpackhi_epi8(rgb, zero);
+
+		__m128i best = _mm_set1_epi32(0x7FFFFFFF);
+		__m128i bestIdx = zero;
+
+		for (int p = 0; p < 4; p++) {
+			__m128i da = _mm_sub_epi16(a, colors[p]);
+			__m128i db = _mm_sub_epi16(b, colors[p]);
+			da = _mm_madd_epi16(da, da);
+			db = _mm_madd_epi16(db, db);
+
+			//pairs of (b+g, r+a) per pixel summed into one distance each
+			__m128i sa = _mm_add_epi32(da, _mm_shuffle_epi32(da, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128i sb = _mm_add_epi32(db, _mm_shuffle_epi32(db, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128i dist = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(sa), _mm_castsi128_ps(sb), _MM_SHUFFLE(2, 0, 2, 0)));
+
+			__m128i closer = _mm_cmplt_epi32(dist, best);
+			best = _mm_or_si128(_mm_and_si128(closer, dist), _mm_andnot_si128(closer, best));
+			bestIdx = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIdx));
+		}
+
+		uint32_t idx[4];
+		_mm_storeu_si128((__m128i*)idx, bestIdx);
+		for (int j = 0; j < 4; j++) indices |= idx[j] << ((i * 4 + j) * 2);
+	}
+
+	writeColorBlock(c0, c1, indices, out);
+}
+
+static
+BlockKernels selectKernels() {
+	if (cpuFeatures().sse2) return { "sse2", colorBlockSSE2 };
+	return { "scalar", colorBlockScalar };
+}
+#else
+static
+BlockKernels selectKernels() {
+	return { "scalar", colorBlockScalar };
+}
+#endif
+
+static
+const BlockKernels& kernels() {
+	static const BlockKernels k = selectKernels();
+	return k;
+}
+
+static
+void alphaBlock(const uint8_t* block, uint8_t* out) {
+	int a0 = 0;
+	int a1 = 255;
+
+	for (int i = 0; i < 16; i++) {
+		int a = block[i * 4 + 3];
+		if (a > a0) a0 = a;
+		if (a < a1) a1 = a;
+	}
+
+	int palette[8] = { a0, a1 };
+	for (int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+
+	uint64_t indices = 0;
+
+	if (a0 != a1) {
+		for (int i = 0; i < 16; i++) {
+			int a = block[i * 4 + 3];
+			int best = 0;
+
+			for (int p = 1; p < 8; p++) {
+				if (abs(a - palette[p]) < abs(a - palette[best])) best = p;
+			}
+
+			indices |= (uint64_t)best << (i * 3);
+		}
+	}
+
+	out[0] = a0;
+	out[1] = a1;
+	for (int i = 0; i < 6; i++) out[2 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+//copies a 4x4 block out of the image, clamping reads at the right and bottom edges
+static
+void gatherBlock(const uint8_t* bgra, int width, int height, int bx, int by, uint8_t* block) {
+	for (int y = 0; y < 4; y++) {
+		int sy = by + y < height ? by + y : height - 1;
+
+		for (int x = 0; x < 4; x++) {
+			int sx = bx + x < width ? bx + x : width - 1;
+			memcpy(&block[(y * 4 + x) * 4], &bgra[((size_t)sy * width + sx) * 4], 4);
+		}
+	}
+}
+
+static
+std::vector<uint8_t> encodeBlocks(const uint8_t* bgra, int width, int height, bool withAlpha) {
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	int blockSize = withAlpha ? 16 : 8;
+
+	std::vector<uint8_t> out((size_t)blocksX * blocksY * blockSize);
+	ColorBlockKernel colorBlock = kernels().color;
+	uint8_t block[64];
+
+	for (int y = 0; y < blocksY; y++) {
+		for (int x = 0; x < blocksX; x++) {
+			uint8_t* dst = &out[((size_t)y * blocksX + x) * blockSize];
+			gatherBlock(bgra, width, height, x * 4, y * 4, block);
+
+			if (withAlpha) {
+				alphaBlock(block, dst);
+				dst += 8;
+			}
+
+			colorBlock(block, dst);
+		}
+	}
+
+	return out;
+}
+
+std::vector<uint8_t> encodeBC1(const uint8_t* bgra, int width, int height) {
+	return encodeBlocks(bgra, width, height, false);
+}
+
+std::vector<uint8_t> encodeBC3(const uint8_t* bgra, int width, int height) {
+	return encodeBlocks(bgra, width, height, true);
+}
+
+bool hasAlpha(const uint8_t* bgra, size_t numPixels) {
+	for (size_t i = 0; i < numPixels; i++) {
+		if (bgra[i * 4 + 3] != 0xFF) return true;
+	}
+
+	return false;
+}
+
+const char* bcKernelName() {
+	return kernels().name;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <inttypes.h>
+
+//bgra pixels in, 4x4 blocks out in row order. edge blocks repeat the last row and column
+//bc1 is 8 bytes per block with no alpha, bc3 adds an 8 byte interpolated alpha block
+std::vector<uint8_t> encodeBC1(const uint8_t* bgra, int width, int height);
+std::vector<uint8_t> encodeBC3(const uint8_t* bgra, int width, int height);
+
+bool hasAlpha(const uint8_t* bgra, size_t numPixels);
+const char* bcKernelName();
\ No newline at end of file
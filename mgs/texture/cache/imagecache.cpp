@@ -0,0 +1,63 @@
+#include "imagecache.h"
+
+namespace fs = std::filesystem;
+
+ImageCache::ImageCache(size_t maxBytes) {
+	this->maxBytes = maxBytes;
+	this->totalBytes = 0;
+}
+
+std::string ImageCache::archiveKey(const fs::path& darPath) {
+	std::error_code ec;
+	std::string key = fs::absolute(darPath, ec).u8string();
+	key += "|" + std::to_string(fs::file_size(darPath, ec));
+	key += "|" + std::to_string(fs::last_write_time(darPath, ec).time_since_epoch().count());
+	return key;
+}
+
+std::shared_ptr<const PcxImage> ImageCache::find(const std::string& archive, uint16_t strcode) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = entries.find({ archive, strcode });
+	if (it == entries.end()) return NULL;
+
+	lru.splice(lru.begin(), lru, it->second);
+	return it->second->image;
+}
+
+void ImageCache::store(const std::string& archive, uint16_t strcode, const std::shared_ptr<const PcxImage>& image) {
+	size_t bytes = pcxBytes(*image);
+	if (bytes > maxBytes) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	Key key = { archive, strcode };
+
+	auto it = entries.find(key);
+	if (it != entries.end()) {
+		totalBytes -= it->second->bytes;
+		lru.erase(it->second);
+		entries.erase(it);
+	}
+
+	lru.push_front({ key, image, bytes });
+	entries[key] = lru.begin();
+	totalBytes += bytes;
+
+	while (totalBytes > maxBytes) {
+		totalBytes -= lru.back().bytes;
+		entries.erase(lru.back().key);
+		lru.pop_back();
+	}
+}
+
+void ImageCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	lru.clear();
+	entries.clear();
+	totalBytes = 0;
+}
+
+size_t ImageCache::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return totalBytes;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <filesystem>
+#include "../pcx/pcx.h"
+
+//decoded images kept in memory between loads, least recently used are dropped past maxBytes
+class ImageCache {
+public:
+	ImageCache(size_t maxBytes);
+
+	//identifies an archive by path, size and modification time
+	static std::string archiveKey(const std::filesystem::path& darPath);
+
+	std::shared_ptr<const PcxImage> find(const std::string& archive, uint16_t strcode);
+	void store(const std::string& archive, uint16_t strcode, const std::shared_ptr<const PcxImage>& image);
+	void clear();
+	size_t size();
+private:
+	typedef std::pair<std::string, uint16_t> Key;
+
+	struct Entry {
+		Key key;
+		std::shared_ptr<const PcxImage> image;
+		size_t bytes;
+	};
+
+	std::mutex mutex;
+	std::list<Entry> lru;
+	std::map<Key, std::list<Entry>::iterator> entries;
+	size_t maxBytes;
+	size_t totalBytes;
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "texturecache.h"
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <string.h>
+#include "../../common/hash.h"
+#include "../../common/cachedir.h"
+
+namespace fs = std::filesystem;
+
+static const uint32_t TEXCACHE_MAGIC = 0x4354474D; //MGTC
+static const uint32_t TEXCACHE_VERSION = 2;
+
+TextureCache::TextureCache(const fs::path& dir, uint64_t maxBytes) {
+	this->dir = dir;
+	this->maxBytes = maxBytes;
+	this->totalBytes = 0;
+	this->scanned = false;
+
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+	loadIndex();
+}
+
+fs::path TextureCache::entryPath(uint64_t darHash, uint16_t strcode) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx_%04x.tex", (unsigned long long)darHash, strcode);
+	return dir / name;
+}
+
+//dar hashes are remembered by path, size and modification time so warm loads don't read the archives.
+//new hashes are appended, so an index holding superseded lines is rewritten with the latest of each
+void TextureCache::loadIndex() {
+	std::ifstream fs(dir / "dars.idx");
+	DarStamp stamp;
+	std::string path;
+	size_t numLines = 0;
+
+	while (fs >> std::hex >> stamp.hash >> std::dec >> stamp.size >> stamp.mtime && std::getline(fs >> std::ws, path)) {
+		stamps[path] = stamp;
+		numLines++;
+	}
+
+	fs.close();
+	if (numLines > stamps.size()) writeIndex();
+}
+
+//drops archives that no longer exist, called with the mutex held or before the cache is shared
+void TextureCache::writeIndex() {
+	std::ostringstream index;
+	std::error_code ec;
+
+	for (auto it = stamps.begin(); it != stamps.end();) {
+		if (!fs::exists(fs::u8path(it->first), ec)) {
+			it = stamps.erase(it);
+			continue;
+		}
+
+		index << std::hex << it->second.hash << std::dec << " " << it->second.size << " " << it->second.mtime << " " << it->first << "\n";
+		++it;
+	}
+
+	std::string text = index.str();
+	writeCacheFile(dir / "dars.idx", text.data(), text.size());
+}
+
+uint64_t TextureCache::darHash(const fs::path& darPath) {
+	std::error_code ec;
+	std::string key = fs::absolute(darPath, ec).u8string();
+
+	DarStamp stamp;
+	stamp.size = fs::file_size(darPath, ec);
+	stamp.mtime = fs::last_write_time(darPath, ec).time_since_epoch().count();
+	if (ec) return 0;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = stamps.find(key);
+		if (it != stamps.end() && it->second.size == stamp.size && it->second.mtime == stamp.mtime) return it->second.hash;
+	}
+
+	std::vector<char> data(stamp.size);
+	std::ifstream fs(darPath, std::ios::binary);
+	fs.read(data.data(), data.size());
+	if (!fs) return 0;
+
+	stamp.hash = hashBytes(data.data(), data.size());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stamps[key] = stamp;
+
+	std::ofstream index(dir / "dars.idx", std::ios::app);
+	index << std::hex << stamp.hash << std::dec << " " << stamp.size << " " << stamp.mtime << " " << key << "\n";
+	return stamp.hash;
+}
+
+bool TextureCache::find(uint64_t darHash, uint16_t strcode, PcxImage& image) {
+	fs::path path = entryPath(darHash, strcode);
+	std::ifstream fs(path, std::ios::binary);
+	if (!fs) return false;
+
+	TextureCacheHeader header;
+	if (!fs.read((char*)&header, sizeof(header))) return false;
+	if (header.magic != TEXCACHE_MAGIC || header.version != TEXCACHE_VERSION) return false;
+	if (header.darHash != darHash || header.strcode != strcode) return false;
+	if (header.width <= 0 || header.height <= 0 || header.width > 0x8000 || header.height > 0x8000) return false;
+
+	size_t numPixels = (size_t)header.width * header.height;
+	image.width = header.width;
+	image.height = header.height;
+	image.pixels.resize(header.pixelsOffset ? numPixels * 4 : 0);
+	image.indices.resize(numPixels);
+	image.palette.resize(header.paletteOffset ? 256 * 4 : 0);
+	if (image.pixels.empty() == image.palette.empty()) return false;
+
+	fs.seekg(header.indicesOffset);
+	fs.read((char*)image.indices.data(), image.indices.size());
+
+	if (header.paletteOffset) {
+		fs.seekg(header.paletteOffset);
+		fs.read((char*)image.palette.data(), image.palette.size());
+	} else {
+		fs.seekg(header.pixelsOffset);
+		fs.read((char*)image.pixels.data(), image.pixels.size());
+	}
+
+	if (!fs) return false;
+
+	fs.close();
+	touchCacheFile(path);
+	return true;
+}
+
+void TextureCache::store(uint64_t darHash, uint16_t strcode, const PcxImage& image) {
+	TextureCacheHeader header = {};
+	header.magic = TEXCACHE_MAGIC;
+	header.version = TEXCACHE_VERSION;
+	header.darHash = darHash;
+	header.strcode = strcode;
+	header.width = image.width;
+	header.height = image.height;
+	header.indicesOffset = sizeof(header);
+
+	uint32_t tailOffset = header.indicesOffset + image.indices.size();
+	if (isIndexed(image)) header.paletteOffset = tailOffset;
+	else header.pixelsOffset = tailOffset;
+
+	const std::vector<uint8_t>& tail = isIndexed(image) ? image.palette : image.pixels;
+	std::vector<uint8_t> data(tailOffset + tail.size());
+	memcpy(&data[0], &header, sizeof(header));
+	memcpy(&data[header.indicesOffset], image.indices.data(), image.indices.size());
+	memcpy(&data[tailOffset], tail.data(), tail.size());
+
+	if (!writeCacheFile(entryPath(darHash, strcode), data.data(), data.size())) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	totalBytes += data.size();
+	if (!scanned || totalBytes > maxBytes) trim();
+}
+
+//trims to three quarters of the limit, so a full cache isn't rescanned on every store.
+//the dar index is compacted alongside, it isn't counted against the limit
+void TextureCache::trim() {
+	totalBytes = trimCacheDir(dir, ".tex", maxBytes, maxBytes / 4 * 3);
+	writeIndex();
+	scanned = true;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include <filesystem>
+#include "../pcx/pcx.h"
+
+//one flat file per texture, header then palette indices then either the palette or bgra pixels
+struct TextureCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t darHash;
+	uint16_t strcode;
+	uint16_t pad;
+	int32_t width;
+	int32_t height;
+	uint32_t pixelsOffset;  //0 when indexed
+	uint32_t indicesOffset;
+	uint32_t paletteOffset; //0 when not indexed
+	uint32_t reserved[2];
+};
+
+//decoded textures keyed by the content hash of the dar they came from, least recently
+//used entries are evicted once the directory grows past maxBytes
+class TextureCache {
+public:
+	TextureCache(const std::filesystem::path& dir, uint64_t maxBytes);
+
+	uint64_t darHash(const std::filesystem::path& darPath);
+	bool find(uint64_t darHash, uint16_t strcode, PcxImage& image);
+	void store(uint64_t darHash, uint16_t strcode, const PcxImage& image);
+private:
+	struct DarStamp {
+		uint64_t size;
+		int64_t mtime;
+		uint64_t hash;
+	};
+
+	std::filesystem::path entryPath(uint64_t darHash, uint16_t strcode);
+	void loadIndex();
+	void writeIndex();
+	void trim();
+
+	std::filesystem::path dir;
+	uint64_t maxBytes;
+	uint64_t totalBytes;
+	bool scanned;
+
+	std::mutex mutex;
+	std::map<std::string, DarStamp> stamps;
+};
\ No newline at end of file
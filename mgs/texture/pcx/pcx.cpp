@@ -0,0 +1,84 @@
+#include "pcx.h"
+#include <string.h>
+#include "../../../image/pcx/dr_pcx.h"
+#include "../../common/memstats.h"
+
+//the palette is rebuilt from the decoded pixels so every bit depth dr_pcx handles maps the same way,
+//true colour pages give indices that don't map to one colour and stay bgra. unused entries are opaque black
+static
+bool buildPalette(const uint8_t* bgra, const uint8_t* indices, size_t numPixels, std::vector<uint8_t>& palette) {
+	uint32_t colors[256];
+	bool seen[256] = {};
+
+	for (size_t i = 0; i < numPixels; i++) {
+		uint32_t color;
+		memcpy(&color, &bgra[i * 4], 4);
+
+		uint8_t index = indices[i];
+		if (!seen[index]) {
+			colors[index] = color;
+			seen[index] = true;
+		} else if (colors[index] != color) {
+			return false;
+		}
+	}
+
+	palette.assign(256 * 4, 0);
+	for (int i = 0; i < 256; i++) {
+		if (seen[i]) memcpy(&palette[i * 4], &colors[i], 4);
+		else palette[i * 4 + 3] = 0xFF;
+	}
+
+	return true;
+}
+
+bool decodePcx(const uint8_t* data, int size, PcxImage& image) {
+	int width;
+	int height;
+	int components;
+
+	drpcx pcxResult{};
+	int loadResult = drpcx_load_memory(&pcxResult, data, size, false, &width, &height, &components, 4);
+	if (loadResult <= 0 || pcxResult.loaded <= 0) return false;
+
+	int numPixels = width * height;
+	image.width = width;
+	image.height = height;
+	image.indices.assign(pcxResult.pPaletteIndices, pcxResult.pPaletteIndices + numPixels);
+
+	if (buildPalette(pcxResult.pImageData, pcxResult.pPaletteIndices, numPixels, image.palette)) {
+		image.pixels.clear();
+	} else {
+		image.palette.clear();
+		image.pixels.assign(pcxResult.pImageData, pcxResult.pImageData + numPixels * 4);
+	}
+
+	//the decoder's two buffers, then the indices and either the palette or the pixels
+	memCount(MEM_PCX, numPixels * 5, 2);
+	memCount(MEM_PCX, pcxBytes(image) - sizeof(PcxImage), 2);
+
+	drpcx_free(pcxResult.pImageData);
+	drpcx_free(pcxResult.pPaletteIndices);
+	memRelease(numPixels * 5);
+	return true;
+}
+
+void releasePcx(PcxImage& image) {
+	memRelease(pcxBytes(image) - sizeof(PcxImage));
+	image = PcxImage();
+}
+
+const uint8_t* pcxPixels(const PcxImage& image, Arena& arena) {
+	if (!isIndexed(image)) return image.pixels.data();
+
+	uint8_t* pixels = arena.allocate<uint8_t>(image.indices.size() * 4);
+	for (size_t i = 0; i < image.indices.size(); i++) {
+		memcpy(&pixels[i * 4], &image.palette[image.indices[i] * 4], 4);
+	}
+
+	return pixels;
+}
+
+size_t pcxBytes(const PcxImage& image) {
+	return image.pixels.size() + image.indices.size() + image.palette.size() + sizeof(PcxImage);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <inttypes.h>
+#include "../../common/arena.h"
+
+//paletted pages keep their indices and a 256 entry palette, pixels is only filled for true colour pages
+struct PcxImage {
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels;  //bgra, top row first, empty when indexed
+	std::vector<uint8_t> indices; //palette index per pixel
+	std::vector<uint8_t> palette; //bgra per index, empty when not indexed
+};
+
+bool decodePcx(const uint8_t* data, int size, PcxImage& image);
+//frees a decoded image's buffers and takes them off the memory stats
+void releasePcx(PcxImage& image);
+
+inline
+bool isIndexed(const PcxImage& image) {
+	return !image.palette.empty();
+}
+
+//bgra of pixel i in either form
+inline
+const uint8_t* pcxPixel(const PcxImage& image, size_t i) {
+	return isIndexed(image) ? &image.palette[image.indices[i] * 4] : &image.pixels[i * 4];
+}
+
+//bgra pixels of the whole image, indexed images are expanded into the arena
+const uint8_t* pcxPixels(const PcxImage& image, Arena& arena);
+size_t pcxBytes(const PcxImage& image);
+
+//implemented alongside the decoder in dr_pcx.h. written to out when given, which must hold 0x12 + dataSize
+//bytes, otherwise to a new[] buffer the caller deletes
+uint8_t* makeTGA(const uint8_t* palette, const uint8_t* data, int dataSize, int16_t width, int16_t height, uint8_t* out = NULL);
+uint8_t* makeTGAPalette(const uint8_t* paletteIndex, int tgaDataSize, int16_t width, int16_t height, uint8_t* out = NULL);
\ No newline at end of file
@@ -1,39 +1,229 @@
+#include <chrono>
 #include <vector>
+#include <unordered_map>
 #include "tool.h"
 
 const char* g_pPluginName = "mgs_kmd";
 const char* g_pPluginDesc = "Metal Gear Solid KMD handler by Jayveer.";
 
 bool checkKMD(BYTE* fileBuffer, int bufferLen, noeRAPI_t* rapi) {
-    return true;
+    return validateKmd(fileBuffer, bufferLen);
 }
 
-noesisModel_t* loadKMD(BYTE* fileBuffer, int bufferLen, int& numMdl, noeRAPI_t* rapi) {
+//welded on the pool, and simplified into lods when previewing them
+void weldGeometry(std::vector<KmdGeometry>& geometry) {
+    g_mgs1Pool->parallelFor(geometry.size(), [&](int i) {
+        weldKmdGeometry(geometry[i]);
+        if (g_mgs1LodPreview) buildKmdLods(geometry[i], g_mgs1LodLevels);
+    });
+}
+
+//cached geometry is already welded and keeps its lods, a miss decodes on the pool and welds before storing
+std::vector<KmdGeometry> loadGeometry(const KmdView& kmd, const BYTE* fileBuffer, int bufferLen) {
+    std::vector<KmdGeometry> geometry;
+    g_mgs1MeshCacheHit = false;
+    int lodLevels = g_mgs1LodPreview ? g_mgs1LodLevels : 0;
+
+    if (!g_mgs1MeshCache) {
+        geometry = decodeKmd(kmd, g_mgs1Pool, g_mgs1QuantizedLoad);
+        if (g_mgs1LodPreview) weldGeometry(geometry);
+        return geometry;
+    }
+
+    uint64_t hash = KmdCache::sourceHash(fileBuffer, bufferLen);
+    g_mgs1MeshCacheHit = g_mgs1MeshCache->find(hash, g_mgs1QuantizedLoad, lodLevels, kmd.numMesh(), geometry);
+    if (g_mgs1MeshCacheHit) return geometry;
+
+    geometry = decodeKmd(kmd, g_mgs1Pool, g_mgs1QuantizedLoad);
+    weldGeometry(geometry);
+
+    g_mgs1MeshCache->store(hash, g_mgs1QuantizedLoad, lodLevels, geometry);
+    return geometry;
+}
+
+//noesis has no lod switching of its own, so previewing swaps each mesh for its coarsest level
+void previewLods(std::vector<KmdGeometry>& geometry) {
+    if (!g_mgs1LodPreview) return;
+
+    for (KmdGeometry& geo : geometry) {
+        if (geo.lods.empty()) continue;
+        KmdGeometry lod = std::move(geo.lods.back());
+        geo = std::move(lod);
+    }
+}
+
+void logMemStats(noeRAPI_t* rapi, const MemStats& stats) {
+    if (!g_mgs1MemStats) return;
+    rapi->LogOutput("memory: %s, peak %.2f MB live, peak resident %.2f MB\n", stats.format().c_str(), stats.peakBytes / 1048576.0, peakResidentBytes() / 1048576.0);
+}
+
+//welded first unless the mesh cache or lod preview already did. runs after the cache so its entries don't depend on the option
+void optimizeGeometry(std::vector<KmdGeometry>& geometry) {
+    if (!g_mgs1OptimizeLoad) return;
+
+    g_mgs1Pool->parallelFor(geometry.size(), [&](int i) {
+        if (!g_mgs1MeshCache && !g_mgs1LodPreview) weldKmdGeometry(geometry[i]);
+        optimizeKmdGeometry(geometry[i]);
+    });
+}
+
+//with the mesh cache on, models still load whole through it, but only meshes no earlier model placed are kept
+StageGeometry loadStageGeometry(const std::vector<StageModel>& models, int& numLoaded, int& numWarm) {
+    numLoaded = numWarm = 0;
+    if (!g_mgs1MeshCache) {
+        StageGeometry stage = decodeStage(models, g_mgs1Pool, g_mgs1QuantizedLoad);
+        if (g_mgs1LodPreview) weldGeometry(stage.meshes);
+        return stage;
+    }
+
+    StageGeometry stage;
+    stage.instances.resize(models.size());
+    std::unordered_map<uint64_t, int> keys;
+
+    for (int i = 0; i < models.size(); i++) {
+        KmdView kmd(models[i].data.data(), models[i].data.size());
+        std::vector<uint64_t> meshKeys;
+        bool needed = false;
+
+        for (int j = 0; j < kmd.numMesh(); j++) {
+            meshKeys.push_back(kmdMeshKey(kmd, j));
+            needed = needed || !keys.count(meshKeys.back());
+        }
+
+        std::vector<KmdGeometry> geometry;
+        if (needed) {
+            geometry = loadGeometry(kmd, models[i].data.data(), models[i].data.size());
+            numLoaded++;
+            if (g_mgs1MeshCacheHit) numWarm++;
+        }
+
+        for (int j = 0; j < meshKeys.size(); j++) {
+            auto it = keys.emplace(meshKeys[j], (int)stage.meshes.size());
+            if (it.second) stage.meshes.push_back(std::move(geometry[j]));
+            stage.instances[i].push_back(it.first->second);
+        }
+    }
+
+    return stage;
+}
+
+//every kmd under the opened model's folder goes into one scene, sharing a single dar scan and material list.
+//each model's bone indices are mapped onto its part of the combined skeleton, repeated meshes share their geometry
+noesisModel_t* loadStage(const StageIndex& stage, int& numMdl, noeRAPI_t* rapi, const MemStats& memStats) {
+    std::vector<StageModel> models = readStageModels(stage);
+    if (models.empty()) return NULL;
+
     void* ctx = rapi->rpgCreateContext();
-    KmdHeader* header = (KmdHeader*)fileBuffer;
-    KmdMesh*   mesh   = (KmdMesh*  )&fileBuffer[0x20];
+    modelBone_t* noeBones = bindStageBones(models, rapi);
+
+    CArrayList<noesisTex_t*>      texList;
+    CArrayList<noesisMaterial_t*> matList;
+
+    auto start = std::chrono::steady_clock::now();
+    int numLoaded, numWarm;
+    StageGeometry geometry = loadStageGeometry(models, numLoaded, numWarm);
+    previewLods(geometry.meshes);
+    optimizeGeometry(geometry.meshes);
+    double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    TextureAtlas atlas;
+    if (g_mgs1AtlasLoad) buildModelAtlas(rapi, stage, geometry.meshes, g_mgs1AtlasPageSize, atlas);
+
+    std::vector<std::vector<int>> boneMaps(models.size());
+    int boneBase = 0;
+
+    for (int i = 0; i < models.size(); i++) {
+        const std::vector<int>& instances = geometry.instances[i];
+        for (int j = 0; j < instances.size(); j++) boneMaps[i].push_back(boneBase + j);
+
+        rapi->rpgSetBoneMap(boneMaps[i].data());
+
+        for (int j = 0; j < instances.size(); j++) {
+            bindMesh(geometry.meshes[instances[j]], &noeBones[boneBase + j], rapi, texList, matList, atlas, stage);
+        }
+
+        boneBase += instances.size();
+    }
 
-    modelBone_t* noeBones = bindKMDBones(mesh, header->numMesh, rapi);
+    rapi->rpgSetBoneMap(NULL);
+
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    char cacheState[32] = "off";
+    if (g_mgs1MeshCache) snprintf(cacheState, sizeof(cacheState), "%d/%d warm", numWarm, numLoaded);
+    rapi->LogOutput("stage of %d models, %d meshes (%d unique), %d materials: geometry %.2f ms, total %.2f ms, mesh cache %s\n",
+        (int)models.size(), boneBase, (int)geometry.meshes.size(), matList.Num(), decodeMs, totalMs, cacheState);
+    logMemStats(rapi, memStats);
+
+    noesisMatData_t* md = rapi->Noesis_GetMatDataFromLists(matList, texList);
+    rapi->rpgSetExData_Materials(md);
+
+    noesisModel_t* mdl = rapi->rpgConstructModel();
+    if (mdl) numMdl = 1;
+
+    rapi->rpgDestroyContext(ctx);
+    scratchArena().release();
+    return mdl;
+}
+
+noesisModel_t* loadKMD(BYTE* fileBuffer, int bufferLen, int& numMdl, noeRAPI_t* rapi) {
+    KmdView kmd(fileBuffer, bufferLen);
+    if (!kmd.isValid()) return NULL;
+
+    std::filesystem::path inputPath{ rapi->Noesis_GetInputName() };
+    StageIndex stage = scanStage(inputPath.parent_path());
+    MemStats memStats;
+    MemStatsScope memScope(g_mgs1MemStats ? &memStats : NULL);
+    if (g_mgs1StageLoad) return loadStage(stage, numMdl, rapi, memStats);
+
+    void* ctx = rapi->rpgCreateContext();
+    KmdSkeleton skeleton;
+    buildKmdSkeleton(kmd, skeleton);
+    modelBone_t* noeBones = bindKMDBones(skeleton, rapi);
 
     CArrayList<noesisTex_t*>      texList;
     CArrayList<noesisMaterial_t*> matList;
 
-    for (int i = 0; i < header->numMesh; i++) {
-        bindMesh(&mesh[i], i, &noeBones[i], fileBuffer, rapi, texList, matList);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<KmdGeometry> geometry = loadGeometry(kmd, fileBuffer, bufferLen);
+    previewLods(geometry);
+    optimizeGeometry(geometry);
+    double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    TextureAtlas atlas;
+    if (g_mgs1AtlasLoad) buildModelAtlas(rapi, stage, geometry, g_mgs1AtlasPageSize, atlas);
+
+    for (int i = 0; i < geometry.size(); i++) {
+        bindMesh(geometry[i], &noeBones[i], rapi, texList, matList, atlas, stage);
     }
 
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const char* cacheState = !g_mgs1MeshCache ? "off" : g_mgs1MeshCacheHit ? "warm" : "cold";
+    rapi->LogOutput("%d meshes: geometry %.2f ms, total %.2f ms, mesh cache %s\n", kmd.numMesh(), decodeMs, totalMs, cacheState);
+
     noesisMatData_t* md = rapi->Noesis_GetMatDataFromLists(matList, texList);
     rapi->rpgSetExData_Materials(md);
 
-    if (g_mgs1OarPrompt && header->numBones) {
-        BYTE* motionFile = openMotion(rapi);
-        if (motionFile) loadMotion(rapi, motionFile, noeBones, header->numBones);
+    if ((g_mgs1OarPrompt || g_mgs1OarAuto) && kmd.numBones()) {
+        std::vector<OarIndexEntry> archives = g_mgs1OarIndex->compatible(inputPath, kmd.numBones());
+        logMotionArchives(rapi, archives, kmd.numBones());
+
+        if (g_mgs1OarAuto && !archives.empty()) {
+            std::vector<uint8_t> motionFile = readMotion(archives[0].path);
+            if (!motionFile.empty()) loadMotion(rapi, motionFile.data(), motionFile.size(), noeBones, kmd.numBones());
+        } else if (g_mgs1OarPrompt) {
+            int motionSize;
+            BYTE* motionFile = openMotion(rapi, motionSize);
+            if (motionFile) loadMotion(rapi, motionFile, motionSize, noeBones, kmd.numBones());
+        }
     }
 
+    logMemStats(rapi, memStats);
+
     noesisModel_t* mdl = rapi->rpgConstructModel();
     if (mdl) numMdl = 1;
 
     rapi->rpgDestroyContext(ctx);
+    scratchArena().release();
     return mdl;
 }
 
@@ -45,13 +235,29 @@ bool NPAPI_InitLocal(void) {
     g_nfn->NPAPI_SetTypeHandler_LoadModel(fh, loadKMD);
 
     applyTools();
+    g_mgs1Pool = new ThreadPool();
+    g_mgs1ImageCache = new ImageCache(g_mgs1ImageCacheSize);
+    g_mgs1OarIndex = new OarIndex();
 
     return true;
 }
 
 
 void NPAPI_ShutdownLocal(void) {
+    delete g_mgs1Pool;
+    g_mgs1Pool = NULL;
+
+    delete g_mgs1TexCache;
+    g_mgs1TexCache = NULL;
+
+    delete g_mgs1MeshCache;
+    g_mgs1MeshCache = NULL;
+
+    delete g_mgs1ImageCache;
+    g_mgs1ImageCache = NULL;
 
+    delete g_mgs1OarIndex;
+    g_mgs1OarIndex = NULL;
 }
 
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD  ul_reason_for_call, LPVOID lpReserved) {
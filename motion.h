@@ -1,141 +1,49 @@
 #pragma once
 #include <vector>
+#include <fstream>
 #include "mgs/common/util.h"
-#include "mgs/motion/oar/oar.h"
+#include "mgs/common/memstats.h"
+#include "mgs/motion/oar/oarmotion.h"
+#include "mgs/motion/oar/oarindex.h"
 #include "noesis/plugin/pluginshare.h"
 
-const double g_mgs1_PI = acos(-1);
-const float  g_mgs1_GAME_FRAMERATE = 30.0f;
-
-struct MoveAnimation {
-    int keyframe;
-    float x;
-    float y;
-    float z;
-};
-
-struct RotAnimation {
-    int keyframe;
-    float x;
-    float y;
-    float z;
-    float w;
-};
-
-inline
-float shiftRadix(const float& f, const int& exponent) {
-    return f * pow(2, exponent);
-}
+const float  g_mgs1_GAME_FRAMERATE = g_oarFrameRate;
 
 inline
-bool checkMagic(BYTE* motionFile) {
-    OarHeader* header = (OarHeader*)motionFile;
-    return header->magic == 0x6152414F;
-}
-
-inline
-BYTE* openMotion(noeRAPI_t* rapi) {
-    int len;
+BYTE* openMotion(noeRAPI_t* rapi, int& len) {
     char out[MAX_NOESIS_PATH];
     BYTE* marFile = rapi->Noesis_LoadPairedFile("load oar", ".oar", len, out);
     if (!marFile) return NULL;
-    return checkMagic(marFile) ? marFile : NULL;
+    return validateOar(marFile, len) ? marFile : NULL;
 }
 
 inline
-RichQuat eulerToQuat(RichVec3 euler) {
-    double cy = cos(euler[2] * 0.5);
-    double sy = sin(euler[2] * 0.5);
-    double cp = cos(euler[1] * 0.5);
-    double sp = sin(euler[1] * 0.5);
-    double cr = cos(euler[0] * 0.5);
-    double sr = sin(euler[0] * 0.5);
-
-    RichQuat qt;
-    qt[0] = sr * cp * cy - cr * sp * sy;
-    qt[1] = cr * sp * cy + sr * cp * sy;
-    qt[2] = cr * cp * sy - sr * sp * cy;
-    qt[3] = cr * cp * cy + sr * sp * sy;
-
-    return qt;
-}
-
-inline
-int32_t negateBits(int32_t val, int numBits) {
-    int hi = numBits - 1;
-    int32_t mx = pow(2, hi);
-    return val >> hi ? val |= -mx : val;
-}
-
-inline
-std::vector<RotAnimation> readRotBitstream(uint16_t* rotBitStream, const int& size, const uint32_t& numFrames) {
-    int keyFrame = 0;
-    std::vector<RotAnimation> ra;
-    RichBitStream bs = RichBitStream(rotBitStream, size * 2);
-
-    uint8_t xL = bs.ReadBits(4);
-    uint8_t yL = bs.ReadBits(4);
-    uint8_t zL = bs.ReadBits(4);
-
-    while (keyFrame < numFrames) {
-        keyFrame += bs.ReadBits(4);
-        uint8_t unknown = bs.ReadBits(4);
-
-        int32_t x = bs.ReadBits(xL); x = negateBits(x, xL);
-        int32_t y = bs.ReadBits(yL); y = negateBits(y, yL);
-        int32_t z = bs.ReadBits(zL); z = negateBits(z, zL);
-
-        float fx = x / 2047.0f * g_mgs1_PI;
-        float fy = y / 2047.0f * g_mgs1_PI;
-        float fz = z / 2047.0f * g_mgs1_PI;
-
-        RichVec3 v3 = { fx, fy, fz };
-        RichQuat qt = eulerToQuat(v3);
-
-        ra.push_back({ keyFrame, qt[0], qt[1], qt[2], qt[3] });
-    }
-
-    return ra;
+std::vector<uint8_t> readMotion(const std::filesystem::path& path) {
+    std::vector<uint8_t> data;
+    std::ifstream fs(path, std::ios::binary | std::ios::ate);
+    if (!fs) return data;
+
+    data.resize((size_t)fs.tellg());
+    fs.seekg(0);
+    if (!fs.read((char*)data.data(), data.size()) || !validateOar(data.data(), data.size())) data.clear();
+    return data;
 }
 
+//archives beside the model that fit it go to the log, best first, so the right one can be picked from the prompt
 inline
-std::vector<MoveAnimation> readMoveBitstream(uint16_t* moveBitStream, const int& size, const uint32_t& numFrames) {
-    int keyFrame = 0;
-    std::vector<MoveAnimation> ma;
-    RichBitStream bs = RichBitStream(moveBitStream, size * 2);
-
-    int32_t y = bs.ReadBits(16);
-    if (y & 0x800) { y |= -0x1000; }
-    float originY = y;
-    ma.push_back({ keyFrame, 0 , originY, 0 });
-
-    uint8_t xL = bs.ReadBits(4);
-    uint8_t yL = bs.ReadBits(4);
-    uint8_t zL = bs.ReadBits(4);
-    uint8_t unk = bs.ReadBits(4);
-
-    if (!xL && !yL && !zL) {
-        return ma;
+void logMotionArchives(noeRAPI_t* rapi, const std::vector<OarIndexEntry>& archives, int numBones) {
+    if (archives.empty()) {
+        rapi->LogOutput("no motion archive beside the model fits its %d bones\n", numBones);
+        return;
     }
 
-    while (keyFrame < numFrames) {
-        keyFrame++; //not sure what determines keyframe, still need to look into it
-        int32_t x = bs.ReadBits(xL); x = negateBits(x, xL);
-        int32_t y = bs.ReadBits(yL); y = negateBits(y, yL);
-        int32_t z = bs.ReadBits(zL); z = negateBits(z, zL);
-
-        float fy = originY + y;
-        float fx = x / 2047.0f * g_mgs1_PI;
-        float fz = z / 2047.0f * g_mgs1_PI;
-        
-        ma.push_back({ keyFrame, fx, fy, fz });
+    for (const OarIndexEntry& archive : archives) {
+        rapi->LogOutput("motion archive %s: %u motions, %u joints\n", archive.path.filename().u8string().c_str(), archive.header.numMotion, archive.header.maxJoint);
     }
-
-    return ma;
 }
 
 inline
-noeKeyFrameData_t createTransKFData(const MoveAnimation& trans, std::vector<float>& aniData) {
+noeKeyFrameData_t createTransKFData(const OarMoveKey& trans, std::vector<float>& aniData) {
     noeKeyFrameData_t data = {};
     data.dataIndex = aniData.size();
     data.time = trans.keyframe / g_mgs1_GAME_FRAMERATE;
@@ -148,7 +56,7 @@ noeKeyFrameData_t createTransKFData(const MoveAnimation& trans, std::vector<floa
 }
 
 inline
-noeKeyFrameData_t createRotKFData(const RotAnimation& rot, std::vector<float>& aniData) {
+noeKeyFrameData_t createRotKFData(const OarRotKey& rot, std::vector<float>& aniData) {
     noeKeyFrameData_t data = {};
     data.dataIndex = aniData.size();
     data.time = rot.keyframe / g_mgs1_GAME_FRAMERATE;
@@ -164,10 +72,9 @@ noeKeyFrameData_t createRotKFData(const RotAnimation& rot, std::vector<float>& a
     return data;
 }
 
+//keys are appended to one array reserved for the whole motion, so bones can point into it
 inline
-std::vector<noeKeyFrameData_t> createKFData(const std::vector<MoveAnimation>& trans, const std::vector<RotAnimation>& rot, const std::vector<MoveAnimation>& scale, std::vector<float>& aniData) {
-    std::vector<noeKeyFrameData_t> kfData;
-
+void createKFData(const std::vector<OarMoveKey>& trans, const std::vector<OarRotKey>& rot, const std::vector<OarMoveKey>& scale, std::vector<float>& aniData, std::vector<noeKeyFrameData_t>& kfData) {
     for (int i = 0; i < trans.size(); i++) {
         noeKeyFrameData_t transData = createTransKFData(trans[i], aniData);
         kfData.push_back(transData);
@@ -182,12 +89,10 @@ std::vector<noeKeyFrameData_t> createKFData(const std::vector<MoveAnimation>& tr
         noeKeyFrameData_t scaleData = createTransKFData(scale[i], aniData);
         kfData.push_back(scaleData);
     }
-
-    return kfData;
 }
 
 inline
-noeKeyFramedBone_t createKFBone(uint32_t boneID, modelBone_t* noeBones, int numBones, int numFrames, const std::vector<MoveAnimation>& trans, const std::vector<RotAnimation>& rot, const std::vector<MoveAnimation>& scale, std::vector<float>& aniData, std::vector<std::vector<noeKeyFrameData_t>>& kfData) {
+noeKeyFramedBone_t createKFBone(uint32_t boneID, modelBone_t* noeBones, int numBones, int numFrames, const std::vector<OarMoveKey>& trans, const std::vector<OarRotKey>& rot, const std::vector<OarMoveKey>& scale, std::vector<float>& aniData, std::vector<noeKeyFrameData_t>& kfData) {
     noeKeyFramedBone_t kfBone = {};
 
     int boneIdx = boneID;
@@ -209,16 +114,15 @@ noeKeyFramedBone_t createKFBone(uint32_t boneID, modelBone_t* noeBones, int numB
 
     kfBone.maxTime = numFrames / g_mgs1_GAME_FRAMERATE;
 
-    std::vector<noeKeyFrameData_t> nkfData = createKFData(trans, rot, scale, aniData);
-    kfData.push_back(nkfData);
+    int transPos = kfData.size();
+    int rotPos = transPos + trans.size();
+    int scalePos = rotPos + rot.size();
 
-    int transPos = 0;
-    int rotPos = (trans.size());
-    int scalePos = (trans.size() + rot.size());
+    createKFData(trans, rot, scale, aniData, kfData);
 
-    if (kfBone.numScaleKeys)        kfBone.scaleKeys = &kfData[kfData.size() - 1][scalePos];
-    if (kfBone.numRotationKeys)     kfBone.rotationKeys = &kfData[kfData.size() - 1][rotPos];
-    if (kfBone.numTranslationKeys)  kfBone.translationKeys = &kfData[kfData.size() - 1][transPos];
+    if (kfBone.numScaleKeys)        kfBone.scaleKeys = &kfData[scalePos];
+    if (kfBone.numRotationKeys)     kfBone.rotationKeys = &kfData[rotPos];
+    if (kfBone.numTranslationKeys)  kfBone.translationKeys = &kfData[transPos];
 
     return kfBone;
 }
@@ -240,65 +144,63 @@ noeKeyFramedAnim_t createKFAnim(char* animName, modelBone_t* noeBones, int numBo
 }
 
 inline
-noesisAnim_t* bindOar(uint8_t* oar, uint8_t* archiveOffset, int maxJoints, int archiveSize, noeRAPI_t* rapi, modelBone_t* noeBones, int numBones) {
-    ArchiveTable* archiveTable = (ArchiveTable*)oar;
+noesisAnim_t* bindOar(const OarMotion& motion, noeRAPI_t* rapi, modelBone_t* noeBones, int numBones) {
+    //sized up front, a motion costs three allocations however many joints it has
+    size_t numRotKeys = 0;
+    for (const std::vector<OarRotKey>& rot : motion.rotation) numRotKeys += rot.size();
 
     std::vector<float> aniData;
     std::vector<noeKeyFramedBone_t> kfBones;
-    std::vector <std::vector<noeKeyFrameData_t>> kfData;
-    
-
-    for (int j = 0; j < maxJoints + 1; j++) {
-        std::vector<RotAnimation>  rot;
-        std::vector<MoveAnimation> trans;
-        std::vector<MoveAnimation> scale;
-
-        if (j == 0) {
-            int moveOffset = archiveTable->archiveOffset[0];
-            uint16_t* moveBitstream = (uint16_t*)&archiveOffset[moveOffset * 2];
-            trans = readMoveBitstream(moveBitstream, archiveSize, archiveTable->numFrames);
-            j++;
-        }
-
-        int boneID = j - 1;
-        int rotOffset = archiveTable->archiveOffset[j];
-        uint16_t* rotBitstream = (uint16_t*)&archiveOffset[rotOffset * 2];
-        rot = readRotBitstream(rotBitstream, archiveSize, archiveTable->numFrames); 
-
-        noeKeyFramedBone_t kfBone = createKFBone(boneID, noeBones, numBones, archiveTable->numFrames, trans, rot, scale, aniData, kfData);
+    std::vector<noeKeyFrameData_t> kfData;
+
+    aniData.reserve(motion.move.size() * 3 + numRotKeys * 4);
+    kfBones.reserve(motion.rotation.size());
+    kfData.reserve(motion.move.size() + numRotKeys);
+    //noesis copies the keys, they're released again when the anim is made
+    size_t keyBytes = aniData.capacity() * sizeof(float) + kfBones.capacity() * sizeof(noeKeyFramedBone_t) + kfData.capacity() * sizeof(noeKeyFrameData_t);
+    memCount(MEM_MOTION, keyBytes, 3);
+
+    const std::vector<OarMoveKey> noKeys;
+
+    for (int j = 0; j < motion.rotation.size(); j++) {
+        const std::vector<OarMoveKey>& trans = j == 0 ? motion.move : noKeys;
+
+        noeKeyFramedBone_t kfBone = createKFBone(j, noeBones, numBones, motion.numFrames, trans, motion.rotation[j], noKeys, aniData, kfData);
         kfBones.push_back(kfBone);
     }
 
-    if (aniData.empty()) return NULL;
+    if (aniData.empty()) {
+        memRelease(keyBytes);
+        return NULL;
+    }
 
     std::string animName = "anim";
     noeKeyFramedAnim_t kfAnim = createKFAnim((char*)animName.c_str(), noeBones, numBones, kfBones, aniData);
 
     noesisAnim_t* anim = rapi->Noesis_AnimFromBonesAndKeyFramedAnim(noeBones, numBones, &kfAnim, true);
+    memRelease(keyBytes);
     return anim;
 }
 
 inline
-void loadMotion(noeRAPI_t* rapi, BYTE* motionFile, modelBone_t* noeBones, int numBones) {
-    OarHeader* oarHeader = (OarHeader*)motionFile;
-
-    if (oarHeader->maxJoint > numBones) return;
-
-    uint8_t* archiveTable = (uint8_t*)&motionFile[0x10];
-
-    int tableEntrySize = (oarHeader->maxJoint + 2) * 2;
-    int oarTableSize   = tableEntrySize * oarHeader->numMotion;
-    uint8_t* archiveOffset = &motionFile[oarTableSize + 0x10];
+void loadMotion(noeRAPI_t* rapi, BYTE* motionFile, int motionSize, modelBone_t* noeBones, int numBones) {
+    if (oarNumJoints(motionFile) > numBones) {
+        rapi->LogOutput("motion archive has %d joints but the model only %d bones, not loaded\n", oarNumJoints(motionFile), numBones);
+        return;
+    }
 
     CArrayList<noesisAnim_t*> animList;
+    OarMotion motion;
 
-    for (int i = 0; i < oarHeader->numMotion; i++) {
-        uint8_t* thisOar = &archiveTable[i * tableEntrySize];
+    for (int i = 0; i < oarNumMotion(motionFile); i++) {
+        if (!decodeOarMotion(motionFile, motionSize, i, motion)) continue;
 
-        noesisAnim_t* anim = bindOar(thisOar, archiveOffset, oarHeader->maxJoint, oarHeader->archiveSize, rapi, noeBones, numBones);
+        noesisAnim_t* anim = bindOar(motion, rapi, noeBones, numBones);
         if (anim) animList.Append(anim);
     }
 
+    releaseOarMotion(motion);
+
     noesisAnim_t* anims = rapi->Noesis_AnimFromAnimsList(animList, animList.Num());
     rapi->rpgSetExData_AnimsNum(anims, 1);
 }
\ No newline at end of file
@@ -5,7 +5,30 @@
 #include "mat.h"
 
 bool g_mgs1OarPrompt = false;
+bool g_mgs1OarAuto = false;
 bool g_mgs1OalphaLoad = false;
+bool g_mgs1QuantizedLoad = false;
+bool g_mgs1OptimizeLoad = false;
+bool g_mgs1LodPreview = false;
+bool g_mgs1TexCacheLoad = false;
+bool g_mgs1MeshCacheLoad = false;
+bool g_mgs1MeshCacheHit = false;
+bool g_mgs1AtlasLoad = false;
+bool g_mgs1CompressLoad = false;
+bool g_mgs1StageLoad = false;
+bool g_mgs1MemStats = false;
+
+ThreadPool* g_mgs1Pool = NULL;
+ImageCache* g_mgs1ImageCache = NULL;
+OarIndex* g_mgs1OarIndex = NULL;
+TextureCache* g_mgs1TexCache = NULL;
+KmdCache* g_mgs1MeshCache = NULL;
+
+const size_t g_mgs1ImageCacheSize = 128 << 20;
+const uint64_t g_mgs1TexCacheSize = 256 << 20;
+const uint64_t g_mgs1MeshCacheSize = 256 << 20;
+const int g_mgs1AtlasPageSize = 1024;
+const int g_mgs1LodLevels = 3;
 
 const char* g_mgs1plugin_name = "Metal Gear Solid";
 
@@ -20,10 +43,68 @@ int mgs1_anim_prompt(int toolIdx, void* user_data) {
     return genericToolSet(g_mgs1OarPrompt, toolIdx);
 }
 
+int mgs1_anim_auto(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1OarAuto, toolIdx);
+}
+
 int mgs1_alpha(int toolIdx, void* user_data) {
     return genericToolSet(g_mgs1OalphaLoad, toolIdx);
 }
 
+int mgs1_quantized(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1QuantizedLoad, toolIdx);
+}
+
+int mgs1_optimize(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1OptimizeLoad, toolIdx);
+}
+
+int mgs1_lodpreview(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1LodPreview, toolIdx);
+}
+
+int mgs1_atlas(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1AtlasLoad, toolIdx);
+}
+
+int mgs1_compress(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1CompressLoad, toolIdx);
+}
+
+int mgs1_stage(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1StageLoad, toolIdx);
+}
+
+int mgs1_memstats(int toolIdx, void* user_data) {
+    return genericToolSet(g_mgs1MemStats, toolIdx);
+}
+
+int mgs1_texcache(int toolIdx, void* user_data) {
+    genericToolSet(g_mgs1TexCacheLoad, toolIdx);
+
+    if (g_mgs1TexCacheLoad && !g_mgs1TexCache) {
+        g_mgs1TexCache = new TextureCache(std::filesystem::temp_directory_path() / "mgs_kmd_texcache", g_mgs1TexCacheSize);
+    } else if (!g_mgs1TexCacheLoad) {
+        delete g_mgs1TexCache;
+        g_mgs1TexCache = NULL;
+    }
+
+    return 1;
+}
+
+int mgs1_meshcache(int toolIdx, void* user_data) {
+    genericToolSet(g_mgs1MeshCacheLoad, toolIdx);
+
+    if (g_mgs1MeshCacheLoad && !g_mgs1MeshCache) {
+        g_mgs1MeshCache = new KmdCache(std::filesystem::temp_directory_path() / "mgs_kmd_meshcache", g_mgs1MeshCacheSize);
+    } else if (!g_mgs1MeshCacheLoad) {
+        delete g_mgs1MeshCache;
+        g_mgs1MeshCache = NULL;
+    }
+
+    return 1;
+}
+
 inline
 int makeTool(char* toolDesc, int (*toolMethod)(int toolIdx, void* userData)) {
     int handle = g_nfn->NPAPI_RegisterTool(toolDesc, toolMethod, NULL);
@@ -34,5 +115,15 @@ int makeTool(char* toolDesc, int (*toolMethod)(int toolIdx, void* userData)) {
 inline
 void applyTools() {
     makeTool("Prompt for Motion Archive", mgs1_anim_prompt);
+    makeTool("Auto-load matching Motion Archive", mgs1_anim_auto);
+    makeTool("Load whole stage", mgs1_stage);
     makeTool("Make alpha (experimental)", mgs1_alpha);
+    makeTool("Quantized vertex buffers", mgs1_quantized);
+    makeTool("Optimize vertex cache", mgs1_optimize);
+    makeTool("Preview coarsest LOD", mgs1_lodpreview);
+    makeTool("Texture atlas", mgs1_atlas);
+    makeTool("Compress textures (BC1/BC3)", mgs1_compress);
+    makeTool("Texture disk cache", mgs1_texcache);
+    makeTool("Mesh disk cache", mgs1_meshcache);
+    makeTool("Memory statistics", mgs1_memstats);
 }
\ No newline at end of file